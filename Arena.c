@@ -0,0 +1,61 @@
+#include "Arena.h"
+
+#define ARENA_BLOCK_SIZE (64 * 1024)
+#define ARENA_ALIGN 16
+
+void *Arena_Alloc(Arena *A, size_t Size)
+{
+    Size = (Size + (ARENA_ALIGN - 1)) & ~(size_t)(ARENA_ALIGN - 1);
+
+    ArenaBlock *Block = A->Head;
+    if (Block == NULL || (Block->Size - Block->Used) < Size)
+    {
+        size_t BlockSize = (Size > ARENA_BLOCK_SIZE) ? Size : ARENA_BLOCK_SIZE;
+        Block = malloc(sizeof(ArenaBlock) + BlockSize);
+        Block->Used = 0;
+        Block->Size = BlockSize;
+
+        if (A->Head && BlockSize != ARENA_BLOCK_SIZE)
+        {
+            // oversized one-off, keep filling the current block after it
+            Block->Next = A->Head->Next;
+            A->Head->Next = Block;
+        }
+        else
+        {
+            Block->Next = A->Head;
+            A->Head = Block;
+        }
+    }
+
+    void *Ptr = Block->Data + Block->Used;
+    Block->Used += Size;
+    return Ptr;
+}
+
+void Arena_Release(Arena *A, ArenaMark Mark)
+{
+    while (A->Head != Mark.Block)
+    {
+        ArenaBlock *OldBlock = A->Head;
+        A->Head = OldBlock->Next;
+        free(OldBlock);
+    }
+
+    if (A->Head)
+    {
+        A->Head->Used = Mark.Used;
+    }
+}
+
+void Arena_Free(Arena *A)
+{
+    ArenaBlock *Block = A->Head;
+    while (Block)
+    {
+        ArenaBlock *OldBlock = Block;
+        Block = OldBlock->Next;
+        free(OldBlock);
+    }
+    A->Head = NULL;
+}
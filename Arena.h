@@ -0,0 +1,42 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stdlib.h>
+
+typedef struct ArenaBlock ArenaBlock;
+
+struct ArenaBlock
+{
+    ArenaBlock *Next;
+    size_t Used;
+    size_t Size;
+    _Alignas(16) unsigned char Data[];
+};
+
+// bump allocator, everything in it is freed at once with Arena_Free
+typedef struct
+{
+    ArenaBlock *Head; // block currently being filled
+} Arena;
+
+// a point to roll the arena back to with Arena_Release
+typedef struct
+{
+    ArenaBlock *Block;
+    size_t Used;
+} ArenaMark;
+
+// memory is not zeroed, same as malloc
+void *Arena_Alloc(Arena *A, size_t Size);
+
+static inline ArenaMark Arena_Mark(Arena *A)
+{
+    return (ArenaMark) { A->Head, A->Head ? A->Head->Used : 0 };
+}
+
+// frees everything allocated since the mark, oversized one-off blocks stick around until Arena_Free
+void Arena_Release(Arena *A, ArenaMark Mark);
+
+void Arena_Free(Arena *A);
+
+#endif // ARENA_H
@@ -0,0 +1,54 @@
+#include <stdlib.h>
+#include "CodeBuffer.h"
+
+#define CODEBUF_INITIAL_CAPACITY (16 * 1024)
+
+void CodeBuf_Grow(CodeBuffer *Code, size_t Extra)
+{
+    size_t Capacity = (Code->Capacity == 0) ? CODEBUF_INITIAL_CAPACITY : Code->Capacity;
+    while (Capacity < Code->Position + Extra)
+    {
+        Capacity *= 2;
+    }
+
+    Code->Data = realloc(Code->Data, Capacity);
+    Code->Capacity = Capacity;
+}
+
+void CodeBuf_Header(CodeBuffer *Code)
+{
+    // let furnvm write it into a scratch memory and copy it out, so its layout stays furnvm's business
+    Memory *Scratch = malloc(sizeof(Memory));
+    Memory_Zero(Scratch);
+
+    BytecodeBuilder Builder = {0};
+    Builder.Mem = Scratch;
+    BCBuild_Header(&Builder);
+
+    for (QWord i = 0; i < Builder.Position; i++)
+    {
+        CodeBuf_Put(Code, Memory_ReadByte(Scratch, i));
+    }
+
+    free(Scratch);
+}
+
+bool CodeBuf_FileWrite(CodeBuffer *Code, const char *Path)
+{
+    FILE *Out = fopen(Path, "wb");
+    if (!Out)
+    {
+        return false;
+    }
+
+    bool Ok = fwrite(Code->Data, 1, Code->Position, Out) == Code->Position;
+    return (fclose(Out) == 0) && Ok;
+}
+
+void CodeBuf_Free(CodeBuffer *Code)
+{
+    free(Code->Data);
+    Code->Data = NULL;
+    Code->Position = 0;
+    Code->Capacity = 0;
+}
@@ -0,0 +1,70 @@
+#ifndef CODEBUFFER_H
+#define CODEBUFFER_H
+
+#include <stdio.h>
+#include <stdbool.h>
+
+#include "../furnvm/BytecodeBuilder.h"
+
+// growable stand in for BytecodeBuilder + Memory, the image is exactly as big as the program
+typedef struct
+{
+    Byte *Data;
+    QWord Position; // next byte goes here, everything before it is the image so far
+    size_t Capacity;
+} CodeBuffer;
+
+void CodeBuf_Grow(CodeBuffer *Code, size_t Extra);
+
+static inline void CodeBuf_Put(CodeBuffer *Code, Byte B)
+{
+    if (Code->Position + 1 > Code->Capacity)
+    {
+        CodeBuf_Grow(Code, 1);
+    }
+    Code->Data[Code->Position++] = B;
+}
+
+// little endian, same as Memory_WriteQWord
+static inline void CodeBuf_WriteQWord(CodeBuffer *Code, QWord Addr, QWord Q)
+{
+    for (int i = 0; i < 8; i++)
+    {
+        Code->Data[Addr + i] = (Byte)(Q >> (8 * i));
+    }
+}
+
+static inline QWord CodeBuf_ReadQWord(const CodeBuffer *Code, QWord Addr)
+{
+    QWord Q = 0;
+    for (int i = 7; i >= 0; i--)
+    {
+        Q = (Q << 8) | Code->Data[Addr + i];
+    }
+    return Q;
+}
+
+static inline void CodeBuf_PutQWord(CodeBuffer *Code, QWord Q)
+{
+    if (Code->Position + 8 > Code->Capacity)
+    {
+        CodeBuf_Grow(Code, 8);
+    }
+    CodeBuf_WriteQWord(Code, Code->Position, Q);
+    Code->Position += 8;
+}
+
+static inline void CodeBuf_PutAddress(CodeBuffer *Code, QWord Address)
+{
+    CodeBuf_PutQWord(Code, Address);
+}
+
+// whatever furnvm puts in front of the code
+void CodeBuf_Header(CodeBuffer *Code);
+
+// only the used part
+bool CodeBuf_FileWrite(CodeBuffer *Code, const char *Path);
+
+void CodeBuf_Free(CodeBuffer *Code);
+
+#endif // CODEBUFFER_H
@@ -3,75 +3,124 @@
 #include <stdarg.h>
 #include <string.h>
 
-void VarNode_FreeAll(VarNode *List)
+static inline void Compiler_Error(Compiler *Cmpl, const char *Fmt, ...)
 {
-    VarNode *Node = List;
-    while (Node)
-    {
-        VarNode *OldNode = Node;
-        Node = OldNode->Next;
-        free(OldNode->Name);
-        if (OldNode->Func)
-        {
-            free(OldNode->Func);
-        }
-        free(OldNode);
-    }
+    va_list Args;
+    va_start(Args, Fmt);
+    vfprintf(stderr, Fmt, Args);
+    va_end(Args);
+    Cmpl->HasErrors = true;
 }
 
-void VarNode_Append(VarNode *List, VarNode *NewNode)
+VarNode *Compiler_VarLookup(Compiler *Cmpl, InternId Name)
 {
-    VarNode *Node = List;
-    while (Node->Next)
+    return SymTable_Lookup(&Cmpl->Syms, Name);
+}
+
+static void Compiler_AddFixup(Compiler *Cmpl, InternId Name, QWord Position)
+{
+    if (Cmpl->FixupCount == Cmpl->FixupCapacity)
     {
-        Node = Node->Next;
+        Cmpl->FixupCapacity = (Cmpl->FixupCapacity == 0) ? 64 : (Cmpl->FixupCapacity * 2);
+        Cmpl->Fixups = realloc(Cmpl->Fixups, Cmpl->FixupCapacity * sizeof(Fixup));
     }
-    Node->Next = NewNode;
+
+    Cmpl->Fixups[Cmpl->FixupCount++] = (Fixup) { Name, Position };
 }
 
-void Compiler_AppendVar(Compiler *Cmpl, VarNode *NewNode)
+// for operands holding a code address, the peephole pass moves code around and has to fix them up
+static void Compiler_AddReloc(Compiler *Cmpl, QWord Position)
 {
-    if (Cmpl->Vars == NULL)
+    if (Cmpl->RelocCount == Cmpl->RelocCapacity)
     {
-        Cmpl->Vars = NewNode;
+        Cmpl->RelocCapacity = (Cmpl->RelocCapacity == 0) ? 256 : (Cmpl->RelocCapacity * 2);
+        Cmpl->Relocs = realloc(Cmpl->Relocs, Cmpl->RelocCapacity * sizeof(QWord));
     }
-    else
+
+    Cmpl->Relocs[Cmpl->RelocCount++] = Position;
+}
+
+static void Compiler_PutCodeAddress(Compiler *Cmpl, QWord Address)
+{
+    Compiler_AddReloc(Cmpl, Cmpl->Code.Position);
+    CodeBuf_PutAddress(&Cmpl->Code, Address);
+}
+
+// for operands naming a string in the pool, Compiler_End swaps in its address once the data is laid out.
+// the builtins come last, so their operands into the runtime's data are the ones at the end
+static void Compiler_AddDataReloc(Compiler *Cmpl, QWord Position)
+{
+    if (Cmpl->DataRelocCount == Cmpl->DataRelocCapacity)
     {
-        VarNode_Append(Cmpl->Vars, NewNode);
+        Cmpl->DataRelocCapacity = (Cmpl->DataRelocCapacity == 0) ? 64 : (Cmpl->DataRelocCapacity * 2);
+        Cmpl->DataRelocs = realloc(Cmpl->DataRelocs, Cmpl->DataRelocCapacity * sizeof(QWord));
     }
+
+    Cmpl->DataRelocs[Cmpl->DataRelocCount++] = Position;
 }
 
-static inline void Compiler_Error(Compiler *Cmpl, const char *Fmt, ...)
+static void Compiler_PutDataAddress(Compiler *Cmpl, QWord Offset)
 {
-    va_list Args;
-    va_start(Args, Fmt);
-    vfprintf(stderr, Fmt, Args);
-    va_end(Args);
-    Cmpl->HasErrors = true;
+    Compiler_AddDataReloc(Cmpl, Cmpl->Code.Position);
+    CodeBuf_PutAddress(&Cmpl->Code, Offset);
+}
+
+// the label is wherever codegen is right now
+static Function *Compiler_DefineFunc(Compiler *Cmpl, InternId Name)
+{
+    Function *Func = SymTable_NewFunc(&Cmpl->Syms);
+    Func->Label = Cmpl->Code.Position;
+    SymTable_Define(&Cmpl->Syms, Name)->Func = Func;
+    return Func;
 }
 
-VarNode *Compiler_VarLookup(Compiler *Cmpl, const char *Name)
+// remembers that the function being compiled references Name, so Compiler_End can tell what main reaches
+static void Compiler_AddCallEdge(Compiler *Cmpl, InternId Name)
 {
-    VarNode *Node = Cmpl->Vars;
-    while (Node)
+    if (Cmpl->CallEdgeCount == Cmpl->CallEdgeCapacity)
     {
-        if (strcmp(Node->Name, Name) == 0)
-        {
-            break;
-        }
-        Node = Node->Next;
+        Cmpl->CallEdgeCapacity = (Cmpl->CallEdgeCapacity == 0) ? 64 : (Cmpl->CallEdgeCapacity * 2);
+        Cmpl->CallEdges = realloc(Cmpl->CallEdges, Cmpl->CallEdgeCapacity * sizeof(CallEdge));
     }
 
-    return Node;
+    uint32_t *Head = Cmpl->Frame.Func ? &Cmpl->Frame.Func->Calls : &Cmpl->RootCalls;
+    Cmpl->CallEdges[Cmpl->CallEdgeCount++] = (CallEdge) { Name, *Head };
+    *Head = Cmpl->CallEdgeCount;
 }
 
-CmplSymbol Compiler_ResolveSymbol(Compiler *Cmpl, Expr_t *Expr)
+// fills in the operand at Position with Name's address.
+// builtins and functions further down have no label yet, those get patched in Compiler_End
+static void Compiler_LinkFunc(Compiler *Cmpl, InternId Name, QWord Position)
 {
-    if (Expr == NULL)
+    Compiler_AddCallEdge(Cmpl, Name);
+    Compiler_AddReloc(Cmpl, Position);
+
+    VarNode *Var = Compiler_VarLookup(Cmpl, Name);
+    if (Var && Var->Func && Var->Func->Label)
     {
-        return (CmplSymbol) { { TYPE_NOT_A_TYPE }, NULL };
+        CodeBuf_WriteQWord(&Cmpl->Code, Position, Var->Func->Label);
+        return;
     }
 
+    Compiler_AddFixup(Cmpl, Name, Position);
+}
+
+static void Compiler_PutFuncAddress(Compiler *Cmpl, InternId Name)
+{
+    QWord Position = Cmpl->Code.Position;
+    CodeBuf_PutAddress(&Cmpl->Code, 0);
+    Compiler_LinkFunc(Cmpl, Name, Position);
+}
+
+CmplSymbol Compiler_ResolveSymbol(Compiler *Cmpl, ExprRef Ref)
+{
+    if (Ref == AST_NULL)
+    {
+        return (CmplSymbol) { { TYPE_NOT_A_TYPE, 0 }, NULL };
+    }
+
+    Expr_t *Expr = Ast_Expr(Cmpl->Pool, Ref);
+
     CmplSymbol Symbol = {0};
     Symbol.Type = (TypeDesc) { TYPE_VOID, 0 };
 
@@ -132,55 +181,120 @@ CmplSymbol Compiler_ResolveSymbol(Compiler *Cmpl, Expr_t *Expr)
     }
 }
 
-void Compiler_GenExpr(Compiler *Cmpl, Expr_t *Expr)
+// A and B, C and D belong to RegAlloc
+#define COMPILER_SCRATCH_COUNT 2
+
+// how many scratch registers an expression needs, anything that can only compute into A needs all of them
+static uint32_t Compiler_ExprNeed(Compiler *Cmpl, ExprRef Ref)
 {
-    if (Expr == NULL)
+    Expr_t *Expr = Ast_Expr(Cmpl->Pool, Ref);
+
+    switch (Expr->Type)
+    {
+    case EXPR_NUMBERLIT:
+    case EXPR_CHARLIT:
+    case EXPR_STRINGLIT:
+        return 1;
+
+    case EXPR_IDENT:
+        return Compiler_VarLookup(Cmpl, Expr->As.Ident) ? 1 : COMPILER_SCRATCH_COUNT;
+
+    case EXPR_DEREF:
+        return Compiler_ExprNeed(Cmpl, Expr->As.Deref);
+
+    case EXPR_BINARYOP:
+    {
+        uint32_t NeedA = Compiler_ExprNeed(Cmpl, Expr->As.BinaryOp.A);
+        uint32_t NeedB = Compiler_ExprNeed(Cmpl, Expr->As.BinaryOp.B);
+        uint32_t Need = (NeedA == NeedB) ? (NeedA + 1) : ((NeedA > NeedB) ? NeedA : NeedB);
+        return (Need > COMPILER_SCRATCH_COUNT) ? (COMPILER_SCRATCH_COUNT + 1) : Need;
+    }
+
+    default:
+        return COMPILER_SCRATCH_COUNT;
+    }
+}
+
+static void Compiler_GenExprInto(Compiler *Cmpl, ExprRef Ref, QWord Dst);
+
+// sethi-ullman, the side needing more registers goes first so the other one fits in whats left.
+// leaves one operand in Dst and the other in the other scratch register
+static void Compiler_GenOperands(Compiler *Cmpl, Expr_t *Expr, QWord Dst, QWord *LeftReg, QWord *RightReg)
+{
+    ExprRef Left = Expr->As.BinaryOp.A;
+    ExprRef Right = Expr->As.BinaryOp.B;
+    uint32_t LeftNeed = Compiler_ExprNeed(Cmpl, Left);
+    uint32_t RightNeed = Compiler_ExprNeed(Cmpl, Right);
+
+    QWord Other = (Dst == REGISTER64_A) ? REGISTER64_B : REGISTER64_A;
+    *LeftReg = Dst;
+    *RightReg = Other;
+
+    if (LeftNeed >= COMPILER_SCRATCH_COUNT && RightNeed >= COMPILER_SCRATCH_COUNT)
+    {
+        // both want every register, park the left side on the stack
+        Compiler_GenExprInto(Cmpl, Left, Dst);
+
+        CodeBuf_Put(&Cmpl->Code, PUSH_QWORD);
+        CodeBuf_PutAddress(&Cmpl->Code, Dst);
+        Cmpl->StackLoc += sizeof(QWord);
+
+        Compiler_GenExprInto(Cmpl, Right, Other);
+
+        CodeBuf_Put(&Cmpl->Code, POP_QWORD);
+        CodeBuf_PutAddress(&Cmpl->Code, Dst);
+        Cmpl->StackLoc -= sizeof(QWord);
+    }
+    else if (LeftNeed >= RightNeed)
+    {
+        Compiler_GenExprInto(Cmpl, Left, Dst);
+        Compiler_GenExprInto(Cmpl, Right, Other);
+    }
+    else
+    {
+        *LeftReg = Other;
+        *RightReg = Dst;
+        Compiler_GenExprInto(Cmpl, Right, Dst);
+        Compiler_GenExprInto(Cmpl, Left, Other);
+    }
+}
+
+// leaves, derefs and binary ops are computed right into Dst, everything else goes through A first
+static void Compiler_GenExprInto(Compiler *Cmpl, ExprRef Ref, QWord Dst)
+{
+    if (Ref == AST_NULL)
     {
         return;
     }
 
+    Expr_t *Expr = Ast_Expr(Cmpl->Pool, Ref);
+    bool InA = false;
+
     switch (Expr->Type)
     {
     case EXPR_NUMBERLIT:
     {
-        BCBuild_Put(&Cmpl->BCBuilder, LOAD_QWORD);
-        BCBuild_PutAddress(&Cmpl->BCBuilder, REGISTER64_A);
-        BCBuild_PutQWord(&Cmpl->BCBuilder, Expr->As.NumberLit);
+        CodeBuf_Put(&Cmpl->Code, LOAD_QWORD);
+        CodeBuf_PutAddress(&Cmpl->Code, Dst);
+        CodeBuf_PutQWord(&Cmpl->Code, Expr->As.NumberLit);
     }
     break;
 
     case EXPR_CHARLIT:
     {
-        BCBuild_Put(&Cmpl->BCBuilder, LOAD_QWORD);
-        BCBuild_PutAddress(&Cmpl->BCBuilder, REGISTER64_A);
-        BCBuild_PutQWord(&Cmpl->BCBuilder, Expr->As.CharLit);
+        CodeBuf_Put(&Cmpl->Code, LOAD_QWORD);
+        CodeBuf_PutAddress(&Cmpl->Code, Dst);
+        CodeBuf_PutQWord(&Cmpl->Code, Expr->As.CharLit);
     }
     break;
 
     case EXPR_STRINGLIT:
     {
-        StringData StringData = Cmpl->StringDataList[0];
-        size_t StringIndex = 0;
-        size_t StringPointer = 0;
-        while (StringData.String)
-        {
-            if (strcmp(StringData.String, Expr->As.StringLit) == 0)
-            {
-                break;
-            }
-            StringPointer += (strlen(StringData.String) + 1);
-            StringData = Cmpl->StringDataList[++StringIndex];
-        }
-        if (StringData.String == NULL)
-        {
-            StringData.String = Expr->As.StringLit;
-        }
+        uint32_t String = StringPool_Add(&Cmpl->Strings, Cmpl->Interns, Expr->As.StringLit);
 
-        Cmpl->StringDataList[StringIndex] = StringData;
-
-        BCBuild_Put(&Cmpl->BCBuilder, LOAD_QWORD);
-        BCBuild_PutAddress(&Cmpl->BCBuilder, REGISTER64_A);
-        BCBuild_PutAddress(&Cmpl->BCBuilder, 2000 + StringPointer);
+        CodeBuf_Put(&Cmpl->Code, LOAD_QWORD);
+        CodeBuf_PutAddress(&Cmpl->Code, Dst);
+        Compiler_PutDataAddress(Cmpl, String);
     }
     break;
 
@@ -190,103 +304,122 @@ void Compiler_GenExpr(Compiler *Cmpl, Expr_t *Expr)
 
         if (Var == NULL)
         {
-            Compiler_Error(Cmpl, "undefined variable '%s'\n", Expr->As.Ident);
+            StrView Name = Intern_View(Cmpl->Interns, Expr->As.Ident);
+            Compiler_Error(Cmpl, "undefined variable '%.*s'\n", (int)Name.Length, Name.Data);
             return;
         }
         else if (Var->Func)
         {
-            BCBuild_Put(&Cmpl->BCBuilder, LOAD_QWORD);
-            BCBuild_PutAddress(&Cmpl->BCBuilder, REGISTER64_A);
-            BCBuild_PutAddress(&Cmpl->BCBuilder, Var->Func->Label);
+            CodeBuf_Put(&Cmpl->Code, LOAD_QWORD);
+            CodeBuf_PutAddress(&Cmpl->Code, Dst);
+            Compiler_PutFuncAddress(Cmpl, Expr->As.Ident);
+        }
+        else if (Var->Register)
+        {
+            CodeBuf_Put(&Cmpl->Code, MOVE_QWORD);
+            CodeBuf_PutAddress(&Cmpl->Code, Var->Register);
+            CodeBuf_PutAddress(&Cmpl->Code, Dst);
         }
         else
         {
-            BCBuild_Put(&Cmpl->BCBuilder, STACK_READ_QWORD);
-            BCBuild_PutQWord(&Cmpl->BCBuilder, Cmpl->StackLoc - Var->AddressOffset);
-            BCBuild_PutAddress(&Cmpl->BCBuilder, REGISTER64_A);
+            CodeBuf_Put(&Cmpl->Code, STACK_READ_QWORD);
+            CodeBuf_PutQWord(&Cmpl->Code, Cmpl->StackLoc - Var->AddressOffset);
+            CodeBuf_PutAddress(&Cmpl->Code, Dst);
         }
     }
     break;
 
     case EXPR_CALL:
     {
-        size_t ArgCount = 0;
-        for (int d = (sizeof(Expr->As.Call.Arguments) / sizeof(Expr->As.Call.Arguments[0])) - 1; d >= 0; d--)
-        {
-            Expr_t *ArgExpr = Expr->As.Call.Arguments[d];
-            if (ArgExpr == NULL)
-            {
-                continue;
-            }
-            ArgCount++;
-        }
-        
+        InA = true;
         // reverse evaluation order
-        for (int i = (ArgCount - 1); i >= 0; i--)
+        for (uint32_t i = Expr->As.Call.ArgCount; i-- > 0;)
         {
-            Expr_t *ArgExpr = Expr->As.Call.Arguments[i];
-            Compiler_GenExpr(Cmpl, ArgExpr);
+            ExprRef ArgExpr = Ast_Arg(Cmpl->Pool, Expr, i);
+            Compiler_GenExprInto(Cmpl, ArgExpr, REGISTER64_A);
 
-            BCBuild_Put(&Cmpl->BCBuilder, PUSH_QWORD);
-            BCBuild_PutAddress(&Cmpl->BCBuilder, REGISTER64_A);
+            CodeBuf_Put(&Cmpl->Code, PUSH_QWORD);
+            CodeBuf_PutAddress(&Cmpl->Code, REGISTER64_A);
+            Cmpl->StackLoc += sizeof(QWord);
         }
 
         CmplSymbol FuncSymbol = Compiler_ResolveSymbol(Cmpl, Expr->As.Call.Callee);
+        Expr_t *Callee = Ast_Expr(Cmpl->Pool, Expr->As.Call.Callee);
 
         if (FuncSymbol.Var)
         {
             if (FuncSymbol.Var->Func)
             {
-                BCBuild_Put(&Cmpl->BCBuilder, CALL);
-                BCBuild_PutAddress(&Cmpl->BCBuilder, FuncSymbol.Var->Func->Label);
+                CodeBuf_Put(&Cmpl->Code, CALL);
+                Compiler_PutFuncAddress(Cmpl, Callee->As.Ident);
             }
         }
+        else if (Callee->Type == EXPR_IDENT)
+        {
+            // might be declared further down, the address gets patched once everything is emitted
+            CodeBuf_Put(&Cmpl->Code, CALL);
+            Compiler_PutFuncAddress(Cmpl, Callee->As.Ident);
+        }
         else
         {
             Compiler_Error(Cmpl, "expected an lvalue to call\n");
 
-            Compiler_GenExpr(Cmpl, Expr->As.Call.Callee);
-            BCBuild_Put(&Cmpl->BCBuilder, MOVE_QWORD);
-            BCBuild_PutAddress(&Cmpl->BCBuilder, REGISTER64_A);
-            BCBuild_PutAddress(&Cmpl->BCBuilder, Cmpl->BCBuilder.Position + 8);
+            Compiler_GenExprInto(Cmpl, Expr->As.Call.Callee, REGISTER64_A);
+            CodeBuf_Put(&Cmpl->Code, MOVE_QWORD);
+            CodeBuf_PutAddress(&Cmpl->Code, REGISTER64_A);
+            Compiler_PutCodeAddress(Cmpl, Cmpl->Code.Position + 8);
 
-            BCBuild_Put(&Cmpl->BCBuilder, CALL);
-            BCBuild_PutAddress(&Cmpl->BCBuilder, 0); // replaced at runtime
+            CodeBuf_Put(&Cmpl->Code, CALL);
+            CodeBuf_PutAddress(&Cmpl->Code, 0); // replaced at runtime
         }
 
         // callee pops args off the stack
+        Cmpl->StackLoc -= Expr->As.Call.ArgCount * sizeof(QWord);
     }
     break;
 
     case EXPR_ASSIGN:
     {
-        if (Expr->As.Assign.Target->Type == EXPR_IDENT)
+        InA = true;
+        Expr_t *Target = Ast_Expr(Cmpl->Pool, Expr->As.Assign.Target);
+        if (Target->Type == EXPR_IDENT)
         {
-            VarNode *Var = Compiler_VarLookup(Cmpl, Expr->As.Assign.Target->As.Ident);
+            VarNode *Var = Compiler_VarLookup(Cmpl, Target->As.Ident);
 
             if (Var == NULL)
             {
-                Compiler_Error(Cmpl, "variable '%s' must be declared before assigning\n", Expr->As.Assign.Target->As.Ident);
+                StrView Name = Intern_View(Cmpl->Interns, Target->As.Ident);
+                Compiler_Error(Cmpl, "variable '%.*s' must be declared before assigning\n", (int)Name.Length, Name.Data);
                 return;
             }
 
-            Compiler_GenExpr(Cmpl, Expr->As.Assign.Expr);
+            Compiler_GenExprInto(Cmpl, Expr->As.Assign.Expr, REGISTER64_A);
 
-            BCBuild_Put(&Cmpl->BCBuilder, STACK_WRITE_QWORD);
-            BCBuild_PutQWord(&Cmpl->BCBuilder, Cmpl->StackLoc - Var->AddressOffset);
-            BCBuild_PutAddress(&Cmpl->BCBuilder, REGISTER64_A);
+            if (Var->Register)
+            {
+                CodeBuf_Put(&Cmpl->Code, MOVE_QWORD);
+                CodeBuf_PutAddress(&Cmpl->Code, REGISTER64_A);
+                CodeBuf_PutAddress(&Cmpl->Code, Var->Register);
+            }
+            else
+            {
+                CodeBuf_Put(&Cmpl->Code, STACK_WRITE_QWORD);
+                CodeBuf_PutQWord(&Cmpl->Code, Cmpl->StackLoc - Var->AddressOffset);
+                CodeBuf_PutAddress(&Cmpl->Code, REGISTER64_A);
+            }
         }
     }
     break;
 
     case EXPR_ADDRESSOF:
     {
+        InA = true;
         CmplSymbol Symbol = Compiler_ResolveSymbol(Cmpl, Expr->As.AddressOf);
         if (Symbol.Var)
         {
-            BCBuild_Put(&Cmpl->BCBuilder, STACK_POINTER_FROM_OFFSET);
-            BCBuild_PutQWord(&Cmpl->BCBuilder, Cmpl->StackLoc - Symbol.Var->AddressOffset);
-            BCBuild_PutAddress(&Cmpl->BCBuilder, REGISTER64_A);
+            CodeBuf_Put(&Cmpl->Code, STACK_POINTER_FROM_OFFSET);
+            CodeBuf_PutQWord(&Cmpl->Code, Cmpl->StackLoc - Symbol.Var->AddressOffset);
+            CodeBuf_PutAddress(&Cmpl->Code, REGISTER64_A);
         }
         else
         {
@@ -297,30 +430,40 @@ void Compiler_GenExpr(Compiler *Cmpl, Expr_t *Expr)
 
     case EXPR_INC:
     {
+        InA = true;
         CmplSymbol Symbol = Compiler_ResolveSymbol(Cmpl, Expr->As.Inc);
-        if (Symbol.Var)
+        if (Symbol.Var && Symbol.Var->Register)
         {
-            BCBuild_Put(&Cmpl->BCBuilder, STACK_READ_QWORD);
-            BCBuild_PutAddress(&Cmpl->BCBuilder, Cmpl->StackLoc - Symbol.Var->AddressOffset);
-            BCBuild_PutAddress(&Cmpl->BCBuilder, REGISTER64_A);
+            CodeBuf_Put(&Cmpl->Code, INC_QWORD);
+            CodeBuf_PutAddress(&Cmpl->Code, Symbol.Var->Register);
 
-            BCBuild_Put(&Cmpl->BCBuilder, INC_QWORD);
-            BCBuild_PutAddress(&Cmpl->BCBuilder, REGISTER64_A);
+            CodeBuf_Put(&Cmpl->Code, MOVE_QWORD);
+            CodeBuf_PutAddress(&Cmpl->Code, Symbol.Var->Register);
+            CodeBuf_PutAddress(&Cmpl->Code, REGISTER64_A);
+        }
+        else if (Symbol.Var)
+        {
+            CodeBuf_Put(&Cmpl->Code, STACK_READ_QWORD);
+            CodeBuf_PutAddress(&Cmpl->Code, Cmpl->StackLoc - Symbol.Var->AddressOffset);
+            CodeBuf_PutAddress(&Cmpl->Code, REGISTER64_A);
+
+            CodeBuf_Put(&Cmpl->Code, INC_QWORD);
+            CodeBuf_PutAddress(&Cmpl->Code, REGISTER64_A);
 
-            BCBuild_Put(&Cmpl->BCBuilder, STACK_WRITE_QWORD);
-            BCBuild_PutAddress(&Cmpl->BCBuilder, Cmpl->StackLoc - Symbol.Var->AddressOffset);
-            BCBuild_PutAddress(&Cmpl->BCBuilder, REGISTER64_A);
+            CodeBuf_Put(&Cmpl->Code, STACK_WRITE_QWORD);
+            CodeBuf_PutAddress(&Cmpl->Code, Cmpl->StackLoc - Symbol.Var->AddressOffset);
+            CodeBuf_PutAddress(&Cmpl->Code, REGISTER64_A);
         }
-        else if (Expr->As.Inc->Type == EXPR_DEREF)
+        else if (Ast_Expr(Cmpl->Pool, Expr->As.Inc)->Type == EXPR_DEREF)
         {
-            Compiler_GenExpr(Cmpl, Expr->As.Inc->As.Deref);
+            Compiler_GenExprInto(Cmpl, Ast_Expr(Cmpl->Pool, Expr->As.Inc)->As.Deref, REGISTER64_A);
 
-            BCBuild_Put(&Cmpl->BCBuilder, MOVE_QWORD);
-            BCBuild_PutAddress(&Cmpl->BCBuilder, REGISTER64_A);
-            BCBuild_PutAddress(&Cmpl->BCBuilder, Cmpl->BCBuilder.Position + 9);
+            CodeBuf_Put(&Cmpl->Code, MOVE_QWORD);
+            CodeBuf_PutAddress(&Cmpl->Code, REGISTER64_A);
+            Compiler_PutCodeAddress(Cmpl, Cmpl->Code.Position + 9);
 
-            BCBuild_Put(&Cmpl->BCBuilder, INC_QWORD);
-            BCBuild_PutAddress(&Cmpl->BCBuilder, 0);
+            CodeBuf_Put(&Cmpl->Code, INC_QWORD);
+            CodeBuf_PutAddress(&Cmpl->Code, 0);
         }
         else
         {
@@ -331,63 +474,43 @@ void Compiler_GenExpr(Compiler *Cmpl, Expr_t *Expr)
 
     case EXPR_DEREF:
     {
-        Compiler_GenExpr(Cmpl, Expr->As.Deref);
-        BCBuild_Put(&Cmpl->BCBuilder, DEREF_QWORD);
-        BCBuild_PutAddress(&Cmpl->BCBuilder, REGISTER64_A);
-        BCBuild_PutAddress(&Cmpl->BCBuilder, REGISTER64_A);
+        Compiler_GenExprInto(Cmpl, Expr->As.Deref, Dst);
+        CodeBuf_Put(&Cmpl->Code, DEREF_QWORD);
+        CodeBuf_PutAddress(&Cmpl->Code, Dst);
+        CodeBuf_PutAddress(&Cmpl->Code, Dst);
     }
     break;
 
     case EXPR_BINARYOP:
     {
+        QWord LeftReg;
+        QWord RightReg;
+        Compiler_GenOperands(Cmpl, Expr, Dst, &LeftReg, &RightReg);
+
         switch (Expr->As.BinaryOp.Op)
         {
         case OP_ADD:
         {
-            Compiler_GenExpr(Cmpl, Expr->As.BinaryOp.A);
-
-            BCBuild_Put(&Cmpl->BCBuilder, PUSH_QWORD);
-            BCBuild_PutAddress(&Cmpl->BCBuilder, REGISTER64_A);
-            Cmpl->StackLoc += sizeof(QWord);
-
-            Compiler_GenExpr(Cmpl, Expr->As.BinaryOp.B);
-
-            BCBuild_Put(&Cmpl->BCBuilder, POP_QWORD);
-            BCBuild_PutAddress(&Cmpl->BCBuilder, REGISTER64_B);
-            Cmpl->StackLoc -= sizeof(QWord);
-
-            BCBuild_Put(&Cmpl->BCBuilder, ADD_QWORD);
-            BCBuild_PutAddress(&Cmpl->BCBuilder, REGISTER64_A);
-            BCBuild_PutAddress(&Cmpl->BCBuilder, REGISTER64_B);
-            BCBuild_PutAddress(&Cmpl->BCBuilder, REGISTER64_A);
+            CodeBuf_Put(&Cmpl->Code, ADD_QWORD);
+            CodeBuf_PutAddress(&Cmpl->Code, Dst);
+            CodeBuf_PutAddress(&Cmpl->Code, LeftReg);
+            CodeBuf_PutAddress(&Cmpl->Code, RightReg);
         }
         break;
 
         case OP_LESSTHAN:
         {
-            Compiler_GenExpr(Cmpl, Expr->As.BinaryOp.A);
+            // left < right is right > left
+            CodeBuf_Put(&Cmpl->Code, COMPARE_QWORD);
+            CodeBuf_PutAddress(&Cmpl->Code, RightReg);
+            CodeBuf_PutAddress(&Cmpl->Code, LeftReg);
 
-            BCBuild_Put(&Cmpl->BCBuilder, PUSH_QWORD);
-            BCBuild_PutAddress(&Cmpl->BCBuilder, REGISTER64_A);
-            Cmpl->StackLoc += sizeof(QWord);
-
-            Compiler_GenExpr(Cmpl, Expr->As.BinaryOp.B);
-
-            BCBuild_Put(&Cmpl->BCBuilder, POP_QWORD);
-            BCBuild_PutAddress(&Cmpl->BCBuilder, REGISTER64_B);
-            Cmpl->StackLoc -= sizeof(QWord);
+            CodeBuf_Put(&Cmpl->Code, LOAD_QWORD);
+            CodeBuf_PutAddress(&Cmpl->Code, Dst);
+            CodeBuf_PutQWord(&Cmpl->Code, 0);
 
-            // op a = rb64, op b = ra64
-            BCBuild_Put(&Cmpl->BCBuilder, COMPARE_QWORD);
-            BCBuild_PutAddress(&Cmpl->BCBuilder, REGISTER64_A);
-            BCBuild_PutAddress(&Cmpl->BCBuilder, REGISTER64_B);
-
-            BCBuild_Put(&Cmpl->BCBuilder, LOAD_QWORD);
-            BCBuild_PutAddress(&Cmpl->BCBuilder, REGISTER64_A);
-            BCBuild_PutQWord(&Cmpl->BCBuilder, 0);
-            
-            BCBuild_Put(&Cmpl->BCBuilder, MAP_GREATER_BYTE);
-            BCBuild_PutAddress(&Cmpl->BCBuilder, REGISTER64_A);
+            CodeBuf_Put(&Cmpl->Code, MAP_GREATER_BYTE);
+            CodeBuf_PutAddress(&Cmpl->Code, Dst);
         }
         break;
 
@@ -402,10 +525,92 @@ void Compiler_GenExpr(Compiler *Cmpl, Expr_t *Expr)
     default:
         break;
     }
+
+    if (InA && Dst != REGISTER64_A)
+    {
+        CodeBuf_Put(&Cmpl->Code, MOVE_QWORD);
+        CodeBuf_PutAddress(&Cmpl->Code, REGISTER64_A);
+        CodeBuf_PutAddress(&Cmpl->Code, Dst);
+    }
+}
+
+void Compiler_GenExpr(Compiler *Cmpl, ExprRef Ref)
+{
+    Compiler_GenExprInto(Cmpl, Ref, REGISTER64_A);
+}
+
+// emits a jump thats taken when Cond is WhenTrue and returns where its target goes.
+// comparisons branch on the compare flags straight away instead of making a 0/1 in A and testing that.
+// theres no jump on greater so the flag still goes through a byte, but only the byte, no LOAD_QWORD 0 to clear the rest
+static QWord Compiler_GenCondJump(Compiler *Cmpl, ExprRef Cond, bool WhenTrue)
+{
+    Expr_t *Expr = Ast_Expr(Cmpl->Pool, Cond);
+
+    if (Expr->Type == EXPR_BINARYOP && Expr->As.BinaryOp.Op == OP_LESSTHAN)
+    {
+        QWord LeftReg;
+        QWord RightReg;
+        Compiler_GenOperands(Cmpl, Expr, REGISTER64_A, &LeftReg, &RightReg);
+
+        // left < right is right > left
+        CodeBuf_Put(&Cmpl->Code, COMPARE_QWORD);
+        CodeBuf_PutAddress(&Cmpl->Code, RightReg);
+        CodeBuf_PutAddress(&Cmpl->Code, LeftReg);
+
+        CodeBuf_Put(&Cmpl->Code, MAP_GREATER_BYTE);
+        CodeBuf_PutAddress(&Cmpl->Code, REGISTER64_A);
+    }
+    else
+    {
+        Compiler_GenExpr(Cmpl, Cond);
+    }
+
+    CodeBuf_Put(&Cmpl->Code, SET_FLAGS_BYTE); // add qword version later but for now byte is fine since its usually 1/0
+    CodeBuf_PutAddress(&Cmpl->Code, REGISTER64_A);
+
+    if (WhenTrue)
+    {
+        CodeBuf_Put(&Cmpl->Code, TICK_FLAGS); // zero is the only flag theres a jump for
+    }
+
+    CodeBuf_Put(&Cmpl->Code, JUMP_IF_ZERO);
+
+    QWord Placeholder = Cmpl->Code.Position;
+    Compiler_PutCodeAddress(Cmpl, 0); // placeholder
+    return Placeholder;
+}
+
+// drops the stack locals, restores the saved registers and pops the params, the return value stays in A
+static void Compiler_GenEpilogue(Compiler *Cmpl)
+{
+    for (size_t Loc = Cmpl->StackLoc; Loc > Cmpl->Frame.LocalsLoc; Loc -= sizeof(QWord))
+    {
+        CodeBuf_Put(&Cmpl->Code, POP_QWORD);
+        CodeBuf_PutAddress(&Cmpl->Code, 0);
+    }
+
+    for (uint32_t i = REGALLOC_COUNT; i-- > 0;)
+    {
+        if (Cmpl->Frame.SavedMask & (1u << i))
+        {
+            CodeBuf_Put(&Cmpl->Code, POP_QWORD);
+            CodeBuf_PutAddress(&Cmpl->Code, RegAlloc_Registers[i]);
+        }
+    }
+
+    for (uint32_t i = 0; i < Cmpl->Frame.ParamCount; i++)
+    {
+        CodeBuf_Put(&Cmpl->Code, POP_QWORD);
+        CodeBuf_PutAddress(&Cmpl->Code, 0);
+    }
+
+    CodeBuf_Put(&Cmpl->Code, RETURN);
 }
 
-void Compiler_GenStmt(Compiler *Cmpl, StmtNode *Stmt)
+void Compiler_GenStmt(Compiler *Cmpl, StmtRef Ref)
 {
+    StmtNode *Stmt = Ast_Stmt(Cmpl->Pool, Ref);
+
     switch (Stmt->Type)
     {
     case STMT_EXPR:
@@ -416,66 +621,51 @@ void Compiler_GenStmt(Compiler *Cmpl, StmtNode *Stmt)
 
     case STMT_FUNC:
     {
-        Function *Func = malloc(sizeof(Function));
-        Func->Label = Cmpl->BCBuilder.Position;
-        Func->Params[0].Name = NULL;
-
+        Function *Func = Compiler_DefineFunc(Cmpl, Stmt->As.Func.Name);
+        Func->ParamCount = Stmt->As.Func.ParamCount;
         Func->ReturnType = Stmt->As.Func.ReturnType;
 
-        VarNode *FuncVar = malloc(sizeof(VarNode));
-        FuncVar->Name = strdup(Stmt->As.Func.Name);
-        FuncVar->Next = NULL;
-        FuncVar->Func = Func;
-        Compiler_AppendVar(Cmpl, FuncVar);
+        FuncFrame OuterFrame = Cmpl->Frame;
+        Cmpl->Frame = (FuncFrame) { Cmpl->StackLoc, 0, Func->ParamCount, RegAlloc_Function(Cmpl->Pool, Ref), Func };
 
-        VarNode *VarBeforeParams = Cmpl->Vars;
-        memcpy(Func->Params, Stmt->As.Func.Params, sizeof(Func->Params)); // copy params
-        for (size_t i = 0; i < sizeof(Func->Params); i++)
+        // params and locals go away with the scope, the caller pushed the last arg first so the first one is on top
+        SymTable_PushScope(&Cmpl->Syms);
+        for (uint32_t i = 0; i < Func->ParamCount; i++)
         {
-            if (Func->Params[i].Name == NULL)
-            {
-                break;
-            }
+            ParamDesc *ParamDesc = Ast_Param(Cmpl->Pool, Stmt, i);
 
-            VarNode *Param = malloc(sizeof(VarNode));
-            Param->Name = strdup(Func->Params[i].Name);
-            Param->Next = NULL;
-            Param->Func = NULL;
-            Param->Type = Func->Params[i].Type;
-            Param->AddressOffset = Cmpl->StackLoc;
-            Compiler_AppendVar(Cmpl, Param);
+            VarNode *Param = SymTable_Define(&Cmpl->Syms, ParamDesc->Name);
+            Param->Type = ParamDesc->Type;
+            Param->AddressOffset = Cmpl->StackLoc + (Func->ParamCount - 1 - i) * sizeof(QWord);
+        }
+        Cmpl->StackLoc += Func->ParamCount * sizeof(QWord);
 
-            Cmpl->StackLoc += sizeof(QWord);
+        // registers holding locals are callee saved
+        for (uint32_t i = 0; i < REGALLOC_COUNT; i++)
+        {
+            if (Cmpl->Frame.SavedMask & (1u << i))
+            {
+                CodeBuf_Put(&Cmpl->Code, PUSH_QWORD);
+                CodeBuf_PutAddress(&Cmpl->Code, RegAlloc_Registers[i]);
+                Cmpl->StackLoc += sizeof(QWord);
+            }
         }
+        Cmpl->Frame.LocalsLoc = Cmpl->StackLoc;
 
         Cmpl->ReturnType = &Func->ReturnType;
-        StmtNode *Node = Stmt->As.Func.Body;
+        StmtRef Node = Stmt->As.Func.Body;
         while (Node)
         {
             Compiler_GenStmt(Cmpl, Node);
-            Node = Node->Next;
+            Node = Ast_Stmt(Cmpl->Pool, Node)->Next;
         }
         Cmpl->ReturnType = NULL;
 
-        for (size_t i = 0; i < sizeof(Func->Params); i++)
-        {
-            if (Func->Params[i].Name == NULL)
-            {
-                break;
-            }
-
-            BCBuild_Put(&Cmpl->BCBuilder, POP_QWORD);
-            BCBuild_PutAddress(&Cmpl->BCBuilder, 0);
+        Compiler_GenEpilogue(Cmpl); // implicit return at end of function
+        Cmpl->StackLoc = Cmpl->Frame.ParamLoc;
+        Cmpl->Frame = OuterFrame;
 
-            Cmpl->StackLoc -= sizeof(QWord);
-        }
-
-        BCBuild_Put(&Cmpl->BCBuilder, RETURN); // implicit return at end of function
-
-        // remove params from variable list
-        (void)VarBeforeParams;
-        // VarNode_FreeAll(VarBeforeParams->Next);
-        // VarBeforeParams->Next = NULL;
+        SymTable_PopScope(&Cmpl->Syms);
     }
     break;
 
@@ -495,30 +685,52 @@ void Compiler_GenStmt(Compiler *Cmpl, StmtNode *Stmt)
             Compiler_GenExpr(Cmpl, Stmt->As.Return);
         }
 
-        BCBuild_Put(&Cmpl->BCBuilder, RETURN);
+        if (Cmpl->ReturnType)
+        {
+            Compiler_GenEpilogue(Cmpl);
+        }
+        else
+        {
+            CodeBuf_Put(&Cmpl->Code, RETURN);
+        }
     }
     break;
 
     case STMT_VARDECL:
     {
-        VarNode *Var = malloc(sizeof(VarNode));
-        Var->Name = strdup(Stmt->As.VarDecl.Name);
-        Var->Next = NULL;
-        Var->Func = NULL;
+        VarNode *Var = SymTable_Define(&Cmpl->Syms, Stmt->As.VarDecl.Name);
         Var->Type = Stmt->As.VarDecl.Type;
         Var->AddressOffset = Cmpl->StackLoc;
-        Compiler_AppendVar(Cmpl, Var);
+        Var->Register = Stmt->As.VarDecl.Register;
+
+        if (Var->Register)
+        {
+            if (Stmt->As.VarDecl.Init)
+            {
+                Compiler_GenExpr(Cmpl, Stmt->As.VarDecl.Init);
+                CodeBuf_Put(&Cmpl->Code, MOVE_QWORD);
+                CodeBuf_PutAddress(&Cmpl->Code, REGISTER64_A);
+                CodeBuf_PutAddress(&Cmpl->Code, Var->Register);
+            }
+            else
+            {
+                CodeBuf_Put(&Cmpl->Code, LOAD_QWORD);
+                CodeBuf_PutAddress(&Cmpl->Code, Var->Register);
+                CodeBuf_PutQWord(&Cmpl->Code, 0);
+            }
+            break;
+        }
 
         if (Stmt->As.VarDecl.Init)
         {
             Compiler_GenExpr(Cmpl, Stmt->As.VarDecl.Init);
-            BCBuild_Put(&Cmpl->BCBuilder, PUSH_QWORD);
-            BCBuild_PutAddress(&Cmpl->BCBuilder, REGISTER64_A);
+            CodeBuf_Put(&Cmpl->Code, PUSH_QWORD);
+            CodeBuf_PutAddress(&Cmpl->Code, REGISTER64_A);
         }
         else
         {
-            BCBuild_Put(&Cmpl->BCBuilder, PUSH_QWORD);
-            BCBuild_PutAddress(&Cmpl->BCBuilder, 0);
+            CodeBuf_Put(&Cmpl->Code, PUSH_QWORD);
+            CodeBuf_PutAddress(&Cmpl->Code, 0);
         }
 
         Cmpl->StackLoc += sizeof(QWord);
@@ -528,29 +740,33 @@ void Compiler_GenStmt(Compiler *Cmpl, StmtNode *Stmt)
 
     case STMT_WHILE:
     {
-        QWord Label = Cmpl->BCBuilder.Position;
-        Compiler_GenExpr(Cmpl, Stmt->As.While.Condition); // TODO: do the jumping and stuff ifnotzero
-
-        BCBuild_Put(&Cmpl->BCBuilder, SET_FLAGS_BYTE); // add qword version later but for now byte is fine since its usually 1/0
-        BCBuild_PutAddress(&Cmpl->BCBuilder, REGISTER64_A);
-
-        BCBuild_Put(&Cmpl->BCBuilder, JUMP_IF_ZERO);
+        // guarded do-while, one test to get in and the test at the bottom jumps back,
+        // so each iteration only takes the one branch
+        QWord Placeholder = Compiler_GenCondJump(Cmpl, Stmt->As.While.Condition, false);
+        QWord Label = Cmpl->Code.Position;
 
-        QWord Placeholder = Cmpl->BCBuilder.Position;
-        BCBuild_PutAddress(&Cmpl->BCBuilder, 0); // placeholder
-
-        StmtNode *Node = Stmt->As.While.Body;
+        SymTable_PushScope(&Cmpl->Syms);
+        size_t BodyLoc = Cmpl->StackLoc;
+        StmtRef Node = Stmt->As.While.Body;
         while (Node)
         {
             Compiler_GenStmt(Cmpl, Node);
-            Node = Node->Next;
+            Node = Ast_Stmt(Cmpl->Pool, Node)->Next;
+        }
+
+        // locals from the body get pushed every time round
+        for (; Cmpl->StackLoc > BodyLoc; Cmpl->StackLoc -= sizeof(QWord))
+        {
+            CodeBuf_Put(&Cmpl->Code, POP_QWORD);
+            CodeBuf_PutAddress(&Cmpl->Code, 0);
         }
+        SymTable_PopScope(&Cmpl->Syms);
 
-        BCBuild_Put(&Cmpl->BCBuilder, JUMP);
-        BCBuild_PutAddress(&Cmpl->BCBuilder, Label);
+        QWord BackEdge = Compiler_GenCondJump(Cmpl, Stmt->As.While.Condition, true);
+        CodeBuf_WriteQWord(&Cmpl->Code, BackEdge, Label);
 
-        QWord BodyEnd = Cmpl->BCBuilder.Position;
-        Memory_WriteQWord(Cmpl->BCBuilder.Mem, Placeholder, BodyEnd);
+        QWord BodyEnd = Cmpl->Code.Position;
+        CodeBuf_WriteQWord(&Cmpl->Code, Placeholder, BodyEnd);
     }
     break;
 
@@ -559,382 +775,245 @@ void Compiler_GenStmt(Compiler *Cmpl, StmtNode *Stmt)
     }
 }
 
-void Compiler_Compile(Compiler *Cmpl)
+void Compiler_Begin(Compiler *Cmpl)
 {
-    Memory Mem;
-    Memory_Zero(&Mem);
-    Cmpl->BCBuilder.Mem = &Mem;
-    BCBuild_Header(&Cmpl->BCBuilder);
-
-    // BCBuild_Put(&Cmpl->BCBuilder, LOAD_LIBRARY);
-    // BCBuild_Put(&Cmpl->BCBuilder, 8); // path length
-    // BCBuild_Put(&Cmpl->BCBuilder, 'b');
-    // BCBuild_Put(&Cmpl->BCBuilder, 'i');
-    // BCBuild_Put(&Cmpl->BCBuilder, 'n');
-    // BCBuild_Put(&Cmpl->BCBuilder, '/');
-    // BCBuild_Put(&Cmpl->BCBuilder, 'l');
-    // BCBuild_Put(&Cmpl->BCBuilder, 'i');
-    // BCBuild_Put(&Cmpl->BCBuilder, 'b');
-    // BCBuild_Put(&Cmpl->BCBuilder, 'c');
-
-    BCBuild_Put(&Cmpl->BCBuilder, CALL);
+    CodeBuf_Header(&Cmpl->Code);
+    Cmpl->CodeStart = Cmpl->Code.Position;
+
+    // CodeBuf_Put(&Cmpl->Code, LOAD_LIBRARY);
+    // CodeBuf_Put(&Cmpl->Code, 8); // path length
+    // CodeBuf_Put(&Cmpl->Code, 'b');
+    // CodeBuf_Put(&Cmpl->Code, 'i');
+    // CodeBuf_Put(&Cmpl->Code, 'n');
+    // CodeBuf_Put(&Cmpl->Code, '/');
+    // CodeBuf_Put(&Cmpl->Code, 'l');
+    // CodeBuf_Put(&Cmpl->Code, 'i');
+    // CodeBuf_Put(&Cmpl->Code, 'b');
+    // CodeBuf_Put(&Cmpl->Code, 'c');
 
     // we dont know main()'s memory address yet
-    size_t Placeholder = Cmpl->BCBuilder.Position;
-    BCBuild_PutAddress(&Cmpl->BCBuilder, 0);
+    CodeBuf_Put(&Cmpl->Code, CALL);
+    Compiler_PutFuncAddress(Cmpl, Intern_Get(Cmpl->Interns, STRVIEW("main")));
 
-    BCBuild_Put(&Cmpl->BCBuilder, MOVE_DYNAMIC);
-    BCBuild_PutAddress(&Cmpl->BCBuilder, REGISTER64_A); // source
-    BCBuild_Put(&Cmpl->BCBuilder, 8);                   // source byte size
-    BCBuild_PutAddress(&Cmpl->BCBuilder, REGISTER_A);   // destination
-    BCBuild_Put(&Cmpl->BCBuilder, 1);                   // destination byte size
+    // whatever is still buffered goes out before exiting
+    CodeBuf_Put(&Cmpl->Code, CALL);
+    Cmpl->ExitFlush = Cmpl->Code.Position;
+    CodeBuf_PutAddress(&Cmpl->Code, 0);
 
-    BCBuild_Put(&Cmpl->BCBuilder, SYSCALL);
-    BCBuild_Put(&Cmpl->BCBuilder, 0); // exit
-    BCBuild_PutAddress(&Cmpl->BCBuilder, REGISTER64_A);
+    CodeBuf_Put(&Cmpl->Code, MOVE_DYNAMIC);
+    CodeBuf_PutAddress(&Cmpl->Code, REGISTER64_A); // source
+    CodeBuf_Put(&Cmpl->Code, 8);                   // source byte size
+    CodeBuf_PutAddress(&Cmpl->Code, REGISTER_A);   // destination
+    CodeBuf_Put(&Cmpl->Code, 1);                   // destination byte size
 
+    CodeBuf_Put(&Cmpl->Code, SYSCALL);
+    CodeBuf_Put(&Cmpl->Code, 0); // exit
+    CodeBuf_PutAddress(&Cmpl->Code, REGISTER64_A);
 
-    
-    
-    // write
+    // only registered here, Compiler_End copies in the ones main can reach
+    for (uint32_t i = 0; i < Cmpl->Runtime->FuncCount; i++)
     {
-        Function *Func = malloc(sizeof(Function));
-        Func->Label = Cmpl->BCBuilder.Position;
-        Func->Params[0].Name = NULL;
-
-        VarNode *FuncVar = malloc(sizeof(VarNode));
-        FuncVar->Name = strdup("write");
-        FuncVar->Next = NULL;
-        FuncVar->Func = Func;
-        Compiler_AppendVar(Cmpl, FuncVar);
-
-        BCBuild_Put(&Cmpl->BCBuilder, POP_QWORD);
-        BCBuild_PutAddress(&Cmpl->BCBuilder, SYSCALL_ARG1);
-
-        BCBuild_Put(&Cmpl->BCBuilder, POP_QWORD);
-        BCBuild_PutAddress(&Cmpl->BCBuilder, SYSCALL_ARG2);
+        const char *Name = Cmpl->Runtime->Funcs[i].Name;
+        Function *Func = SymTable_NewFunc(&Cmpl->Syms);
+        Func->Builtin = i + 1;
+        SymTable_Define(&Cmpl->Syms, Intern_Get(Cmpl->Interns, (StrView) { Name, strlen(Name) }))->Func = Func;
+    }
+}
 
-        BCBuild_Put(&Cmpl->BCBuilder, SYSCALL);
-        BCBuild_Put(&Cmpl->BCBuilder, 1); // write stdout
-        BCBuild_PutAddress(&Cmpl->BCBuilder, REGISTER64_A);
+// copies a builtin out of the runtime blob to the end of the code, moving its addresses along with it
+static void Compiler_SpliceBuiltin(Compiler *Cmpl, Function *Func)
+{
+    const Runtime *Rt = Cmpl->Runtime;
+    const RuntimeFunc *Builtin = &Rt->Funcs[Func->Builtin - 1];
 
-        // arguments already popped off the stack
-        BCBuild_Put(&Cmpl->BCBuilder, RETURN);
+    Func->Label = Cmpl->Code.Position;
+    if (Cmpl->Code.Position + Builtin->Size > Cmpl->Code.Capacity)
+    {
+        CodeBuf_Grow(&Cmpl->Code, Builtin->Size);
     }
+    memcpy(Cmpl->Code.Data + Func->Label, Rt->Code + Builtin->Offset, Builtin->Size);
+    Cmpl->Code.Position += Builtin->Size;
 
-    // inc
+    for (uint32_t i = 0; i < Builtin->RelocCount; i++)
     {
-        Function *Func = malloc(sizeof(Function));
-        Func->Label = Cmpl->BCBuilder.Position;
-        Func->Params[0].Name = NULL;
-
-        VarNode *FuncVar = malloc(sizeof(VarNode));
-        FuncVar->Name = strdup("inc");
-        FuncVar->Next = NULL;
-        FuncVar->Func = Func;
-        Compiler_AppendVar(Cmpl, FuncVar);
-
-        BCBuild_Put(&Cmpl->BCBuilder, POP_QWORD);
-        BCBuild_PutAddress(&Cmpl->BCBuilder, REGISTER64_A);
-
-        BCBuild_Put(&Cmpl->BCBuilder, LOAD_QWORD);
-        BCBuild_PutAddress(&Cmpl->BCBuilder, REGISTER64_B);
-        BCBuild_PutQWord(&Cmpl->BCBuilder, 1);
-
-        BCBuild_Put(&Cmpl->BCBuilder, MOVE_QWORD);
-        BCBuild_PutAddress(&Cmpl->BCBuilder, REGISTER64_A);
-        BCBuild_PutAddress(&Cmpl->BCBuilder, Cmpl->BCBuilder.Position + 9);
-
-        BCBuild_Put(&Cmpl->BCBuilder, INC_QWORD);
-        BCBuild_PutAddress(&Cmpl->BCBuilder, 0);
-
-        // arguments already popped off the stack
-        BCBuild_Put(&Cmpl->BCBuilder, RETURN);
+        QWord Position = Func->Label + (Rt->Relocs[Builtin->FirstReloc + i] - Builtin->Offset);
+        QWord Address = CodeBuf_ReadQWord(&Cmpl->Code, Position);
+        CodeBuf_WriteQWord(&Cmpl->Code, Position, Func->Label + (Address - Builtin->Offset));
+        Compiler_AddReloc(Cmpl, Position);
     }
 
-    // strlen
+    for (uint32_t i = 0; i < Builtin->DataCount; i++)
     {
-        Function *Func = malloc(sizeof(Function));
-        Func->Label = Cmpl->BCBuilder.Position;
-        Func->Params[0].Name = NULL;
-
-        VarNode *FuncVar = malloc(sizeof(VarNode));
-        FuncVar->Name = strdup("strlen");
-        FuncVar->Next = NULL;
-        FuncVar->Func = Func;
-        Compiler_AppendVar(Cmpl, FuncVar);
-
-        BCBuild_Put(&Cmpl->BCBuilder, POP_QWORD);
-        BCBuild_PutAddress(&Cmpl->BCBuilder, REGISTER64_A);
-
-        // save original pointer to subtract later
-        BCBuild_Put(&Cmpl->BCBuilder, MOVE_QWORD);
-        BCBuild_PutAddress(&Cmpl->BCBuilder, REGISTER64_A);
-        BCBuild_PutAddress(&Cmpl->BCBuilder, REGISTER64_B);
-
-        QWord Label = Cmpl->BCBuilder.Position;
-
-        BCBuild_Put(&Cmpl->BCBuilder, DEREF_BYTE);
-        BCBuild_PutAddress(&Cmpl->BCBuilder, REGISTER64_A);
-        BCBuild_PutAddress(&Cmpl->BCBuilder, REGISTER_A);
-
-        BCBuild_Put(&Cmpl->BCBuilder, SET_FLAGS_BYTE);
-        BCBuild_PutAddress(&Cmpl->BCBuilder, REGISTER_A);
-
-        BCBuild_Put(&Cmpl->BCBuilder, JUMP_IF_ZERO);
-
-        QWord Placeholder = Cmpl->BCBuilder.Position;
-        BCBuild_PutAddress(&Cmpl->BCBuilder, 0); //placeholder
-
-        BCBuild_Put(&Cmpl->BCBuilder, INC_QWORD);
-        BCBuild_PutAddress(&Cmpl->BCBuilder, REGISTER64_A);
-
-        BCBuild_Put(&Cmpl->BCBuilder, JUMP);
-        BCBuild_PutAddress(&Cmpl->BCBuilder, Label);
-
-        Memory_WriteQWord(Cmpl->BCBuilder.Mem, Placeholder, Cmpl->BCBuilder.Position);
-        
-        BCBuild_Put(&Cmpl->BCBuilder, SUB_QWORD);
-        BCBuild_PutAddress(&Cmpl->BCBuilder, REGISTER64_A);
-        BCBuild_PutAddress(&Cmpl->BCBuilder, REGISTER64_A);
-        BCBuild_PutAddress(&Cmpl->BCBuilder, REGISTER64_B);
-
-        // arguments already popped off the stack
-        BCBuild_Put(&Cmpl->BCBuilder, RETURN);
+        Compiler_AddDataReloc(Cmpl, Func->Label + (Rt->DataRelocs[Builtin->FirstData + i] - Builtin->Offset));
     }
 
-    // printf
+    // builtins can call other builtins, those edges land on Func
+    Cmpl->Frame.Func = Func;
+    for (uint32_t i = 0; i < Builtin->CallCount; i++)
     {
-        Function *Func = malloc(sizeof(Function));
-        Func->Label = Cmpl->BCBuilder.Position;
-        Func->Params[0].Name = NULL;
-
-        VarNode *FuncVar = malloc(sizeof(VarNode));
-        FuncVar->Name = strdup("printf");
-        FuncVar->Next = NULL;
-        FuncVar->Func = Func;
-        Compiler_AppendVar(Cmpl, FuncVar);
-
-        // copy qword off the stack
-        BCBuild_Put(&Cmpl->BCBuilder, POP_QWORD);
-        BCBuild_PutAddress(&Cmpl->BCBuilder, REGISTER64_A);
-
-        BCBuild_Put(&Cmpl->BCBuilder, LOAD_BYTE);
-        BCBuild_PutAddress(&Cmpl->BCBuilder, REGISTER_B);
-        BCBuild_Put(&Cmpl->BCBuilder, '%');
-
-        QWord WhileLabel = Cmpl->BCBuilder.Position;
-
-        // while condition
-
-        BCBuild_Put(&Cmpl->BCBuilder, DEREF_BYTE);
-        BCBuild_PutAddress(&Cmpl->BCBuilder, REGISTER64_A);
-        BCBuild_PutAddress(&Cmpl->BCBuilder, REGISTER_A);
-
-        BCBuild_Put(&Cmpl->BCBuilder, SET_FLAGS_BYTE);
-        BCBuild_PutAddress(&Cmpl->BCBuilder, REGISTER_A);
-
-        BCBuild_Put(&Cmpl->BCBuilder, JUMP_IF_ZERO);
-
-        QWord WhilePlaceholder = Cmpl->BCBuilder.Position;
-        BCBuild_PutAddress(&Cmpl->BCBuilder, 0); // placeholder
-
-        // while body begin
-
-        BCBuild_Put(&Cmpl->BCBuilder, MOVE_QWORD);
-        BCBuild_PutAddress(&Cmpl->BCBuilder, REGISTER64_A);
-        BCBuild_PutAddress(&Cmpl->BCBuilder, REGISTER64_D);
-
-        BCBuild_Put(&Cmpl->BCBuilder, LOAD_QWORD);
-        BCBuild_PutAddress(&Cmpl->BCBuilder, SYSCALL_ARG2);
-        BCBuild_Put(&Cmpl->BCBuilder, 1);
-
-        BCBuild_Put(&Cmpl->BCBuilder, SYSCALL);
-        BCBuild_Put(&Cmpl->BCBuilder, 1);
-        BCBuild_PutAddress(&Cmpl->BCBuilder, 0);
-        
-        BCBuild_Put(&Cmpl->BCBuilder, MOVE_QWORD);
-        BCBuild_PutAddress(&Cmpl->BCBuilder, REGISTER64_D);
-        BCBuild_PutAddress(&Cmpl->BCBuilder, REGISTER64_A);
-
-        // if condition
-
-        BCBuild_Put(&Cmpl->BCBuilder, COMPARE_BYTE);
-        BCBuild_Put(&Cmpl->BCBuilder, REGISTER_A);
-        BCBuild_Put(&Cmpl->BCBuilder, REGISTER_B);
-
-        BCBuild_Put(&Cmpl->BCBuilder, TICK_FLAGS); // logical not
-        BCBuild_Put(&Cmpl->BCBuilder, JUMP_IF_EQUAL);
-
-        QWord IfPlaceholder = Cmpl->BCBuilder.Position;
-        BCBuild_PutAddress(&Cmpl->BCBuilder, 0); // placeholder
-
-        // if body begin
-
-        BCBuild_Put(&Cmpl->BCBuilder, MOVE_QWORD);
-        BCBuild_PutAddress(&Cmpl->BCBuilder, REGISTER64_A);
-        BCBuild_PutAddress(&Cmpl->BCBuilder, REGISTER64_D);
-
-        BCBuild_Put(&Cmpl->BCBuilder, LOAD_BYTE);
-        BCBuild_PutAddress(&Cmpl->BCBuilder, REGISTER_C);
-        BCBuild_Put(&Cmpl->BCBuilder, '_');
-
-        BCBuild_Put(&Cmpl->BCBuilder, LOAD_QWORD);
-        BCBuild_PutAddress(&Cmpl->BCBuilder, SYSCALL_ARG1);
-        BCBuild_PutQWord(&Cmpl->BCBuilder, REGISTER_C);
-
-        BCBuild_Put(&Cmpl->BCBuilder, LOAD_QWORD);
-        BCBuild_PutAddress(&Cmpl->BCBuilder, SYSCALL_ARG2);
-        BCBuild_PutQWord(&Cmpl->BCBuilder, 1);
+        const RuntimeCall *Call = &Rt->Calls[Builtin->FirstCall + i];
+        const char *Name = Rt->Funcs[Call->Callee].Name;
+        Compiler_LinkFunc(Cmpl, Intern_Get(Cmpl->Interns, (StrView) { Name, strlen(Name) }), Func->Label + (Call->Position - Builtin->Offset));
+    }
+    Cmpl->Frame.Func = NULL;
+}
 
-        BCBuild_Put(&Cmpl->BCBuilder, SYSCALL);
-        BCBuild_Put(&Cmpl->BCBuilder, 1);
-        BCBuild_PutAddress(&Cmpl->BCBuilder, 0);
+// walks the references from the top level down, copying in each builtin the first time it shows up
+static void Compiler_EmitReachedBuiltins(Compiler *Cmpl)
+{
+    // every function goes in once, the ones only builtins call are builtins themselves
+    Function **Queue = malloc((Cmpl->CallEdgeCount + Cmpl->Runtime->FuncCount) * sizeof(Function *));
+    size_t Head = 0, Tail = 0;
 
-        BCBuild_Put(&Cmpl->BCBuilder, MOVE_QWORD);
-        BCBuild_PutAddress(&Cmpl->BCBuilder, REGISTER64_D);
-        BCBuild_PutAddress(&Cmpl->BCBuilder, REGISTER64_A);
+    uint32_t Edge = Cmpl->RootCalls;
+    for (;;)
+    {
+        for (; Edge; Edge = Cmpl->CallEdges[Edge - 1].Next)
+        {
+            VarNode *Var = Compiler_VarLookup(Cmpl, Cmpl->CallEdges[Edge - 1].Callee);
+            if (!Var || !Var->Func || Var->Func->Reached)
+            {
+                continue; // undefined ones get reported with the fixups
+            }
 
-        // if body end
+            Var->Func->Reached = true;
+            Queue[Tail++] = Var->Func;
+        }
 
-        Memory_WriteQWord(Cmpl->BCBuilder.Mem, IfPlaceholder, Cmpl->BCBuilder.Position);
+        if (Head == Tail)
+        {
+            break;
+        }
 
-        // while body end
+        Function *Func = Queue[Head++];
+        if (Func->Builtin && !Func->Label)
+        {
+            Compiler_SpliceBuiltin(Cmpl, Func);
+        }
+        Edge = Func->Calls;
+    }
 
-        BCBuild_Put(&Cmpl->BCBuilder, INC_QWORD);
-        BCBuild_PutAddress(&Cmpl->BCBuilder, REGISTER64_A);
+    free(Queue);
+}
 
-        BCBuild_Put(&Cmpl->BCBuilder, JUMP);
-        BCBuild_PutAddress(&Cmpl->BCBuilder, WhileLabel);
+void Compiler_End(Compiler *Cmpl)
+{
+    VarNode *MainVar = Compiler_VarLookup(Cmpl, Intern_Get(Cmpl->Interns, STRVIEW("main")));
+    if (!MainVar || !MainVar->Func)
+    {
+        Compiler_Error(Cmpl, "main function was not found\n");
+        CodeBuf_Free(&Cmpl->Code);
+        return;
+    }
 
-        Memory_WriteQWord(Cmpl->BCBuilder.Mem, WhilePlaceholder, Cmpl->BCBuilder.Position);
+    size_t StringRelocCount = Cmpl->DataRelocCount;
+    Compiler_EmitReachedBuiltins(Cmpl);
+    CodeBuf_Put(&Cmpl->Code, END_INSTRUCTIONS);
 
-        // arguments already popped off the stack
-        BCBuild_Put(&Cmpl->BCBuilder, RETURN);
+    // the program never printed through the buffer if nothing reached flush
+    InternId FlushName = Intern_Get(Cmpl->Interns, STRVIEW("flush"));
+    VarNode *Flush = Compiler_VarLookup(Cmpl, FlushName);
+    if (Flush && Flush->Func && Flush->Func->Reached)
+    {
+        Compiler_LinkFunc(Cmpl, FlushName, Cmpl->ExitFlush);
     }
-
-    // puts
+    else
     {
-        Function *Func = malloc(sizeof(Function));
-        Func->Label = Cmpl->BCBuilder.Position;
-        Func->Params[0].Name = NULL;
-
-        VarNode *FuncVar = malloc(sizeof(VarNode));
-        FuncVar->Name = strdup("puts");
-        FuncVar->Next = NULL;
-        FuncVar->Func = Func;
-        Compiler_AppendVar(Cmpl, FuncVar);
-
-        // copy qword off the stack
-        BCBuild_Put(&Cmpl->BCBuilder, STACK_READ_QWORD);
-        BCBuild_PutQWord(&Cmpl->BCBuilder, sizeof(QWord));
-        BCBuild_PutAddress(&Cmpl->BCBuilder, REGISTER64_A);
-
-        BCBuild_Put(&Cmpl->BCBuilder, PUSH_QWORD);
-        BCBuild_PutAddress(&Cmpl->BCBuilder, REGISTER64_A);
-
-        BCBuild_Put(&Cmpl->BCBuilder, CALL);
-        BCBuild_PutAddress(&Cmpl->BCBuilder, Compiler_VarLookup(Cmpl, "strlen")->Func->Label);
-
-        BCBuild_Put(&Cmpl->BCBuilder, PUSH_QWORD);
-        BCBuild_PutAddress(&Cmpl->BCBuilder, REGISTER64_A);
-
-        BCBuild_Put(&Cmpl->BCBuilder, STACK_READ_QWORD);
-        BCBuild_PutQWord(&Cmpl->BCBuilder, sizeof(QWord) * 2);
-        BCBuild_PutAddress(&Cmpl->BCBuilder, REGISTER64_A);
-
-        BCBuild_Put(&Cmpl->BCBuilder, PUSH_QWORD);
-        BCBuild_PutAddress(&Cmpl->BCBuilder, REGISTER64_A);
-
-        BCBuild_Put(&Cmpl->BCBuilder, CALL);
-        BCBuild_PutAddress(&Cmpl->BCBuilder, Compiler_VarLookup(Cmpl, "write")->Func->Label);
-
-        // pop caller's arguments off the stack
-        BCBuild_Put(&Cmpl->BCBuilder, POP_QWORD);
-        BCBuild_PutAddress(&Cmpl->BCBuilder, 0);
-        
-        BCBuild_Put(&Cmpl->BCBuilder, RETURN);
+        for (QWord i = Cmpl->ExitFlush - 1; i < Cmpl->ExitFlush + sizeof(QWord); i++)
+        {
+            Cmpl->Code.Data[i] = NOP;
+        }
     }
 
-    // putchar
+    // only the global scope is left by now, so this sees every function
+    for (size_t i = 0; i < Cmpl->FixupCount; i++)
     {
-        Function *Func = malloc(sizeof(Function));
-        Func->Label = Cmpl->BCBuilder.Position;
-        Func->Params[0].Name = NULL;
-
-        VarNode *FuncVar = malloc(sizeof(VarNode));
-        FuncVar->Name = strdup("putchar");
-        FuncVar->Next = NULL;
-        FuncVar->Func = Func;
-        Compiler_AppendVar(Cmpl, FuncVar);
-
-        BCBuild_Put(&Cmpl->BCBuilder, STACK_POINTER_FROM_OFFSET);
-        BCBuild_PutAddress(&Cmpl->BCBuilder, 8);
-        BCBuild_PutAddress(&Cmpl->BCBuilder, SYSCALL_ARG1);
-
-        BCBuild_Put(&Cmpl->BCBuilder, LOAD_QWORD);
-        BCBuild_PutAddress(&Cmpl->BCBuilder, SYSCALL_ARG2);
-        BCBuild_PutAddress(&Cmpl->BCBuilder, 1);
-
-        BCBuild_Put(&Cmpl->BCBuilder, SYSCALL);
-        BCBuild_Put(&Cmpl->BCBuilder, SYSNUM_WRITE_OUT);
-        BCBuild_PutAddress(&Cmpl->BCBuilder, REGISTER64_A);
-
-        BCBuild_Put(&Cmpl->BCBuilder, POP_QWORD);
-        BCBuild_PutAddress(&Cmpl->BCBuilder, 0);
-
-        BCBuild_Put(&Cmpl->BCBuilder, RETURN);
+        Fixup *Fix = &Cmpl->Fixups[i];
+        VarNode *Var = Compiler_VarLookup(Cmpl, Fix->Name);
+        if (!Var || !Var->Func)
+        {
+            StrView Name = Intern_View(Cmpl->Interns, Fix->Name);
+            Compiler_Error(Cmpl, "undefined function '%.*s'\n", (int)Name.Length, Name.Data);
+            continue;
+        }
+        CodeBuf_WriteQWord(&Cmpl->Code, Fix->Position, Var->Func->Label);
     }
 
-    // dumpstate
+    // every jump target is known now, FCC_PEEPHOLE=0 turns it off and FCC_PEEPHOLE=stats reports what it did
+    const char *Peephole = getenv("FCC_PEEPHOLE");
+    if (!Cmpl->HasErrors && !(Peephole && strcmp(Peephole, "0") == 0))
     {
-        Function *Func = malloc(sizeof(Function));
-        Func->Label = Cmpl->BCBuilder.Position;
-        Func->Params[0].Name = NULL;
-
-        VarNode *FuncVar = malloc(sizeof(VarNode));
-        FuncVar->Name = strdup("dumpstate");
-        FuncVar->Next = NULL;
-        FuncVar->Func = Func;
-        Compiler_AppendVar(Cmpl, FuncVar);
-
-        BCBuild_Put(&Cmpl->BCBuilder, DUMP_STATE);
-        BCBuild_Put(&Cmpl->BCBuilder, RETURN);
+        PeepholeStats Stats;
+        if (Peephole_Run(&Cmpl->Code, Cmpl->CodeStart, Cmpl->Relocs, Cmpl->RelocCount, Cmpl->DataRelocs, Cmpl->DataRelocCount, &Stats)
+            && Peephole && strcmp(Peephole, "stats") == 0)
+        {
+            fprintf(stderr, "peephole: removed %zu instructions, %zu bytes\n", Stats.RemovedInstructions, Stats.RemovedBytes);
+        }
     }
 
-    while (Cmpl->Stmt)
+    // the data section goes right after the code, now that the code is done moving
+    QWord DataStart = Cmpl->Code.Position;
+    char *Data;
+    size_t DataSize = StringPool_Layout(&Cmpl->Strings, &Data);
+    for (size_t i = 0; i < DataSize; i++)
     {
-        Compiler_GenStmt(Cmpl, Cmpl->Stmt);
-        Cmpl->Stmt = Cmpl->Stmt->Next;
+        CodeBuf_Put(&Cmpl->Code, Data[i]);
     }
+    free(Data);
 
-    BCBuild_EndInstructions(&Cmpl->BCBuilder);
-
-    VarNode *MainVar = Compiler_VarLookup(Cmpl, "main");
-    if (!MainVar || !MainVar->Func)
+    for (size_t i = 0; i < StringRelocCount; i++)
     {
-        Compiler_Error(Cmpl, "main function was not found\n");
-        return;
+        if (Cmpl->DataRelocs[i] == PEEPHOLE_DEAD_MOVE)
+        {
+            continue; // the instruction was removed as unreachable
+        }
+
+        QWord String = CodeBuf_ReadQWord(&Cmpl->Code, Cmpl->DataRelocs[i]);
+        if (String >= Cmpl->Strings.Count)
+        {
+            Compiler_Error(Cmpl, "string operand at %llu doesnt name a string\n", (unsigned long long)Cmpl->DataRelocs[i]);
+            continue;
+        }
+        CodeBuf_WriteQWord(&Cmpl->Code, Cmpl->DataRelocs[i], DataStart + Cmpl->Strings.Strings[String].Offset);
     }
-    Memory_WriteQWord(Cmpl->BCBuilder.Mem, Placeholder, MainVar->Func->Label);
 
-    size_t StrCount = 0;
-    for (size_t i = 0; i < (sizeof(Cmpl->StringDataList) / sizeof(Cmpl->StringDataList[0])); i++)
+    // then the runtime's data if any builtin uses it, FCC_STDOUT=line flushes stdout on every newline
+    if (Cmpl->DataRelocCount > StringRelocCount)
     {
-        const char *String = Cmpl->StringDataList[i].String;
-        if (String == NULL)
+        while (Cmpl->Code.Position % sizeof(QWord))
         {
-            break;
+            CodeBuf_Put(&Cmpl->Code, 0);
         }
 
-        for (size_t j = 0; j < strlen(String) + 1 /* null terminator */; j++)
+        QWord RuntimeData = Cmpl->Code.Position;
+        for (size_t i = 0; i < RUNTIME_DATA_SIZE; i++)
         {
-            Memory_WriteByte(Cmpl->BCBuilder.Mem, 2000 + StrCount++, String[j]);
+            CodeBuf_Put(&Cmpl->Code, Cmpl->Runtime->Data[i]);
         }
+
+        const char *Mode = getenv("FCC_STDOUT");
+        if (Mode && strcmp(Mode, "line") == 0)
+        {
+            CodeBuf_WriteQWord(&Cmpl->Code, RuntimeData + RUNTIME_OUT_LINE_BUFFERED, 1);
+        }
+
+        for (size_t i = StringRelocCount; i < Cmpl->DataRelocCount; i++)
+        {
+            if (Cmpl->DataRelocs[i] == PEEPHOLE_DEAD_MOVE)
+            {
+                continue;
+            }
+
+            QWord Offset = CodeBuf_ReadQWord(&Cmpl->Code, Cmpl->DataRelocs[i]);
+            CodeBuf_WriteQWord(&Cmpl->Code, Cmpl->DataRelocs[i], RuntimeData + Offset);
+        }
+    }
+
+    if (!CodeBuf_FileWrite(&Cmpl->Code, "out"))
+    {
+        Compiler_Error(Cmpl, "failed to write out\n");
     }
 
-    FILE *Out = fopen("out", "wb");
-    Memory_FileWrite(Cmpl->BCBuilder.Mem, Out);
-    fclose(Out);
+    CodeBuf_Free(&Cmpl->Code);
 }
 
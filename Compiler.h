@@ -4,60 +4,89 @@
 
 #include <stdio.h>
 #include "Parser.h"
+#include "SymTable.h"
+#include "RegAlloc.h"
+#include "Peephole.h"
+#include "CodeBuffer.h"
+#include "StringPool.h"
+#include "Runtime.h"
 #include <stdbool.h>
 
 #include "../furnvm/BytecodeBuilder.h"
 
 typedef struct
 {
-    size_t Label;
-
-    struct
-    {
-        const char *Name;
-        TypeDesc Type;
-    } Params[6];
-
-    TypeDesc ReturnType;
-} Function;
+    TypeDesc Type;
+    VarNode *Var;
+} CmplSymbol;
 
-typedef struct VarNode VarNode;
 
-struct VarNode
+// one function referencing another by name, kept in a list per caller
+typedef struct
 {
-    char *Name;
-    TypeDesc Type;
-    QWord AddressOffset;
-    Function *Func;
-    VarNode *Next;
-};
+    InternId Callee;
+    uint32_t Next; // index + 1, 0 ends the list
+} CallEdge;
 
+// a call to a function that wasnt declared yet, patched in Compiler_End
 typedef struct
 {
-    TypeDesc Type;
-    VarNode *Var;
-} CmplSymbol;
+    InternId Name;
+    QWord Position; // address operand to overwrite
+} Fixup;
 
+// what a return has to undo in the function being compiled
 typedef struct
 {
-    const char *String;
-} StringData;
-
+    size_t ParamLoc; // StackLoc before the params
+    size_t LocalsLoc; // StackLoc after the saved registers, stack locals go above it
+    uint32_t ParamCount;
+    uint32_t SavedMask; // RegAlloc_Registers the prologue pushed
+    Function *Func; // NULL at the top level
+} FuncFrame;
 
 typedef struct
 {
-    StmtNode *Stmt;
-    VarNode *Vars;
+    AstPool *Pool;
+    InternTable *Interns;
+    SymTable Syms;
     bool HasErrors;
     TypeDesc *ReturnType;
-    StringData StringDataList[10];
-    BytecodeBuilder BCBuilder;
+    StringPool Strings;
+    CodeBuffer Code;
     size_t StackLoc;
+    FuncFrame Frame;
+
+    Fixup *Fixups;
+    size_t FixupCount;
+    size_t FixupCapacity;
+
+    QWord CodeStart; // right after the header
+    QWord *Relocs; // positions of operands that hold code addresses
+    size_t RelocCount;
+    size_t RelocCapacity;
+
+    QWord *DataRelocs; // positions of operands that hold a string pool index until Compiler_End
+    size_t DataRelocCount;
+    size_t DataRelocCapacity;
+
+    CallEdge *CallEdges;
+    uint32_t CallEdgeCount;
+    uint32_t CallEdgeCapacity;
+    uint32_t RootCalls; // made outside any function, like the call to main
+    QWord ExitFlush; // operand of the call to flush before exiting, only linked if something else reached flush
+
+    const Runtime *Runtime; // where the builtins are copied from
 } Compiler;
 
-void Compiler_Compile(Compiler *Cmpl);
+// for feeding the compiler one top level declaration at a time, nothing is kept that
+// points into the ast after Compiler_GenStmt returns so it can be freed right away
+void Compiler_Begin(Compiler *Cmpl);
+
+void Compiler_GenStmt(Compiler *Cmpl, StmtRef Ref);
 
-void VarNode_FreeAll(VarNode *List);
+// emits the builtins main can reach, resolves forward calls, places the strings and writes the output file
+void Compiler_End(Compiler *Cmpl);
 
 #endif // COMPILER_H
 
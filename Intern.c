@@ -0,0 +1,88 @@
+#include "Intern.h"
+
+static inline uint32_t Intern_Hash(StrView Str)
+{
+    // fnv-1a
+    uint32_t Hash = 2166136261u;
+    for (size_t i = 0; i < Str.Length; i++)
+    {
+        Hash ^= (unsigned char)Str.Data[i];
+        Hash *= 16777619u;
+    }
+    return Hash;
+}
+
+static void Intern_Rehash(InternTable *Table, size_t NewBucketCount)
+{
+    free(Table->Buckets);
+    Table->Buckets = calloc(NewBucketCount, sizeof(InternId));
+    Table->BucketCount = NewBucketCount;
+
+    size_t Mask = NewBucketCount - 1;
+    for (InternId Id = 1; Id < Table->Count; Id++)
+    {
+        size_t Slot = Intern_Hash(Intern_View(Table, Id)) & Mask;
+        while (Table->Buckets[Slot] != INTERN_NONE)
+        {
+            Slot = (Slot + 1) & Mask;
+        }
+        Table->Buckets[Slot] = Id;
+    }
+}
+
+InternId Intern_Get(InternTable *Table, StrView Str)
+{
+    if (Table->Count == 0)
+    {
+        // reserve id 0
+        Table->Chunks[0] = malloc(sizeof(StrView) << INTERN_CHUNK_BITS);
+        Table->Chunks[0][0] = (StrView) { "", 0 };
+        Table->Count = 1;
+        Intern_Rehash(Table, 128);
+    }
+
+    size_t Mask = Table->BucketCount - 1;
+    size_t Slot = Intern_Hash(Str) & Mask;
+    while (Table->Buckets[Slot] != INTERN_NONE)
+    {
+        InternId Id = Table->Buckets[Slot];
+        if (StrView_Equal(Intern_View(Table, Id), Str))
+        {
+            return Id;
+        }
+        Slot = (Slot + 1) & Mask;
+    }
+
+    InternId NewId = Table->Count++;
+
+    // first id of a new chunk
+    uint32_t Chunk = 31 - __builtin_clz((NewId >> INTERN_CHUNK_BITS) + 1);
+    if (Table->Chunks[Chunk] == NULL)
+    {
+        Table->Chunks[Chunk] = malloc(sizeof(StrView) << (INTERN_CHUNK_BITS + Chunk));
+    }
+
+    *Intern_Slot(Table, NewId) = Str;
+    Table->Buckets[Slot] = NewId;
+
+    // keep the load factor under 1/2
+    if (Table->Count * 2 > Table->BucketCount)
+    {
+        Intern_Rehash(Table, Table->BucketCount * 2);
+    }
+
+    return NewId;
+}
+
+void InternTable_Free(InternTable *Table)
+{
+    for (size_t i = 0; i < INTERN_MAX_CHUNKS; i++)
+    {
+        free(Table->Chunks[i]);
+        Table->Chunks[i] = NULL;
+    }
+    free(Table->Buckets);
+    Table->Buckets = NULL;
+    Table->Count = 0;
+    Table->BucketCount = 0;
+}
@@ -0,0 +1,59 @@
+#ifndef INTERN_H
+#define INTERN_H
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdbool.h>
+
+typedef struct
+{
+    const char *Data; // not null terminated
+    size_t Length;
+} StrView;
+
+#define STRVIEW(Lit) ((StrView) { (Lit), sizeof(Lit) - 1 })
+
+static inline bool StrView_Equal(StrView A, StrView B)
+{
+    return A.Length == B.Length && memcmp(A.Data, B.Data, A.Length) == 0;
+}
+
+// 0 is never handed out so it can mean "no name"
+typedef uint32_t InternId;
+
+#define INTERN_NONE 0
+
+// the first chunk holds 64 strings and every one after it twice as many as the one before
+#define INTERN_CHUNK_BITS 6
+#define INTERN_MAX_CHUNKS 27 // enough for every 32 bit id
+
+// every distinct identifier/literal spelling gets one id, so comparing names is comparing ids
+typedef struct
+{
+    // indexed by id, views point into the source (not copied), chunks never move once allocated
+    // so a view that was handed to another thread stays valid while the lexer keeps interning
+    StrView *Chunks[INTERN_MAX_CHUNKS];
+    size_t Count;
+
+    InternId *Buckets; // open addressing, INTERN_NONE means empty
+    size_t BucketCount; // power of 2
+} InternTable;
+
+InternId Intern_Get(InternTable *Table, StrView Str);
+
+static inline StrView *Intern_Slot(InternTable *Table, InternId Id)
+{
+    uint32_t Chunk = 31 - __builtin_clz((Id >> INTERN_CHUNK_BITS) + 1);
+    uint32_t First = ((1u << Chunk) - 1) << INTERN_CHUNK_BITS;
+    return &Table->Chunks[Chunk][Id - First];
+}
+
+static inline StrView Intern_View(InternTable *Table, InternId Id)
+{
+    return *Intern_Slot(Table, Id);
+}
+
+void InternTable_Free(InternTable *Table);
+
+#endif // INTERN_H
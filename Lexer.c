@@ -1,152 +1,187 @@
 
 #include "Lexer.h"
+#include "LexerScan.h"
 #include <stdio.h>
 #include <string.h>
 #include <stdbool.h>
 
 static inline bool IsSpace(char c)
 {
-    return c == ' ' || c == '\n' || c == '\t';
+    return CharClass[(unsigned char)c] & CHAR_SPACE;
 }
 
 static inline bool IsIdent(char c)
 {
-    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c == '_');
+    return CharClass[(unsigned char)c] & CHAR_IDENT;
 }
 
 static inline bool IsDigit(char c)
 {
-    return (c >= '0' && c <= '9');
+    return CharClass[(unsigned char)c] & CHAR_DIGIT;
 }
 
-TokNode *TokNode_New(TokType Type)
+static inline bool IsIdentOrDigit(char c)
 {
-    TokNode *NewToken = malloc(sizeof(TokNode));
-    NewToken->Type = Type;
-    NewToken->Next = NULL;
-    NewToken->String = NULL;
-    return NewToken;
+    return CharClass[(unsigned char)c] & (CHAR_IDENT | CHAR_DIGIT);
 }
 
-void TokNode_FreeAll(TokNode *List)
+// reads past the end of the input come back as 0
+static inline char Lexer_CharAt(Lexer *Lex, size_t Pos)
 {
-    TokNode *Node = List;
-    while (Node)
-    {
-        TokNode *OldNode = Node;
-        Node = OldNode->Next;
-        free(OldNode->String);
-        free(OldNode);
-    }
+    return (Pos < Lex->Length) ? Lex->Input[Pos] : 0;
 }
 
-void TokNode_Append(TokNode *List, TokNode *NewNode)
+void TokArray_Free(TokArray *Tokens)
 {
-    TokNode *Node = List;
-    while (Node->Next)
-    {
-        Node = Node->Next;
-    }
-    Node->Next = NewNode;
+    free(Tokens->Data);
+    Tokens->Data = NULL;
+    Tokens->Count = 0;
+    Tokens->Capacity = 0;
 }
 
-void Lexer_AppendToken(Lexer *Lex, TokNode *NewToken)
+size_t Lexer_Unescape(StrView Raw, char *Out, size_t OutLen)
 {
-    if (Lex->Tokens == NULL)
+    size_t Len = 0;
+    for (size_t i = 0; i < Raw.Length; i++)
     {
-        Lex->Tokens = NewToken;
+        char c = Raw.Data[i];
+        if (c == '\\' && (i + 1) < Raw.Length)
+        {
+            switch (Raw.Data[++i])
+            {
+            case 'n':
+                c = '\n';
+                break;
+
+            default:
+                c = Raw.Data[i];
+                break;
+            }
+        }
+
+        if (Out && Len < OutLen)
+        {
+            Out[Len] = c;
+        }
+        Len++;
     }
-    else
+
+    return Len;
+}
+
+#define KEYWORD(Lit, Type) \
+    if (StrView_Equal(Word, STRVIEW(Lit))) \
+    { \
+        return Type; \
+    }
+
+// switch on length then first char so at most one memcmp runs per identifier,
+// no matter how many keywords get added
+static TokType Lexer_KeywordType(StrView Word)
+{
+    switch (Word.Length)
     {
-        TokNode_Append(Lex->Tokens, NewToken);
+    case 3:
+        KEYWORD("int", TOK_INT);
+        break;
+
+    case 4:
+        switch (Word.Data[0])
+        {
+        case 'c':
+            KEYWORD("char", TOK_CHAR);
+            break;
+        case 'v':
+            KEYWORD("void", TOK_VOID);
+            break;
+        default:
+            break;
+        }
+        break;
+
+    case 5:
+        KEYWORD("while", TOK_WHILE);
+        break;
+
+    case 6:
+        KEYWORD("return", TOK_RETURN);
+        break;
+
+    default:
+        break;
     }
+
+    return TOK_IDENT;
 }
 
-void Lexer_Tokenize(Lexer *Lex)
+#undef KEYWORD
+
+bool Lexer_Next(Lexer *Lex, Token *Out)
 {
-    size_t Length = strlen(Lex->Input);
+    if (Lex->Scan == NULL)
+    {
+        Lex->Scan = LexerScan_Get();
+    }
+
+    size_t Length = Lex->Length;
+    const LexerScan *Scan = Lex->Scan;
 
     size_t *pPos = &Lex->Pos;
-    for (*pPos = 0; *pPos < Length; ++(*pPos))
+    for (; *pPos < Length; ++(*pPos))
     {
         char c = Lex->Input[*pPos];
 
-        if (IsIdent(c) || IsDigit(c))
-        {
-            TokNode *NewToken = TokNode_New(IsDigit(c) ? TOK_NUMBERLIT : TOK_IDENT);
+        Out->Offset = *pPos;
+        Out->Length = 1;
+        Out->Id = INTERN_NONE;
 
-            size_t Len = 1;
-            // spaghetti loop >:)
-            for (size_t c = Lex->Input[++(*pPos)];
-                 IsIdent(c) || IsDigit(c);
-                 c = Lex->Input[++(*pPos)])
-            {
-                Len++;
-            }
+        if (IsIdentOrDigit(c))
+        {
+            Out->Type = IsDigit(c) ? TOK_NUMBERLIT : TOK_IDENT;
 
-            NewToken->String = malloc(Len + 1);
-            strncpy(NewToken->String, &Lex->Input[*pPos - Len], Len);
-            NewToken->String[Len] = 0;
-            (*pPos)--;
+            size_t End = Scan->SkipIdent(Lex->Input, *pPos + 1, Length);
+            Out->Length = End - *pPos;
+            *pPos = End - 1;
 
-            if (strcmp(NewToken->String, "return") == 0)
-            {
-                NewToken->Type = TOK_RETURN;
-            }
-            else if (strcmp(NewToken->String, "while") == 0)
+            if (Out->Type == TOK_IDENT)
             {
-                NewToken->Type = TOK_WHILE;
-            }
-            else if (strcmp(NewToken->String, "void") == 0)
-            {
-                NewToken->Type = TOK_VOID;
-            }
-            else if (strcmp(NewToken->String, "int") == 0)
-            {
-                NewToken->Type = TOK_INT;
-            }
-            else if (strcmp(NewToken->String, "char") == 0)
-            {
-                NewToken->Type = TOK_CHAR;
+                StrView Word = Lexer_TokView(Lex, Out);
+                Out->Type = Lexer_KeywordType(Word);
+                if (Out->Type == TOK_IDENT)
+                {
+                    Out->Id = Intern_Get(Lex->Interns, Word);
+                }
             }
-
-            Lexer_AppendToken(Lex, NewToken);
         }
         else if (c == '"' || c == '\'')
         {
             (*pPos)++;
-            TokNode *NewToken = TokNode_New((c == '\'') ? TOK_CHARLIT : TOK_STRINGLIT);
+            Out->Type = (c == '\'') ? TOK_CHARLIT : TOK_STRINGLIT;
+            Out->Offset = *pPos;
 
-            char Buffer[256] = {0};
-            size_t BufPos = 0;
-
-            while (Lex->Input[*pPos] != c)
+            // only find the end here, escapes get decoded by Lexer_Unescape when someone needs the bytes
+            while ((*pPos < Length) && Lex->Input[*pPos] != c)
             {
-                char c = Lex->Input[*pPos];
-                if (c == '\\')
+                if (Lex->Input[*pPos] == '\\')
                 {
-                    switch (Lex->Input[++(*pPos)])
-                    {
-                    case 'n':
-                        c = '\n';
-                        break;
-
-                    default:
-                        c = Lex->Input[*pPos];
-                        break;
-                    }
+                    (*pPos)++;
                 }
-                Buffer[BufPos++] = c;
                 (*pPos)++;
             }
 
-            NewToken->String = strdup(Buffer);
+            size_t End = (*pPos < Length) ? *pPos : Length;
+            Out->Length = End - Out->Offset;
 
-            Lexer_AppendToken(Lex, NewToken);
+            if (Out->Type == TOK_STRINGLIT)
+            {
+                Out->Id = Intern_Get(Lex->Interns, Lexer_TokView(Lex, Out));
+            }
         }
         else if (IsSpace(c))
         {
-            continue; // ignore whitespace
+            // ignore whitespace
+            *pPos = Scan->SkipSpace(Lex->Input, *pPos + 1, Length) - 1;
+            continue;
         }
         else
         {
@@ -154,63 +189,75 @@ void Lexer_Tokenize(Lexer *Lex)
             switch (c)
             {
             case '(':
-                Lexer_AppendToken(Lex, TokNode_New(TOK_OPAREN));
+                Out->Type = TOK_OPAREN;
                 break;
             case ')':
-                Lexer_AppendToken(Lex, TokNode_New(TOK_CPAREN));
+                Out->Type = TOK_CPAREN;
                 break;
             case '{':
-                Lexer_AppendToken(Lex, TokNode_New(TOK_OBRACE));
+                Out->Type = TOK_OBRACE;
                 break;
             case '}':
-                Lexer_AppendToken(Lex, TokNode_New(TOK_CBRACE));
+                Out->Type = TOK_CBRACE;
                 break;
             case ',':
-                Lexer_AppendToken(Lex, TokNode_New(TOK_COMMA));
+                Out->Type = TOK_COMMA;
                 break;
             case ';':
-                Lexer_AppendToken(Lex, TokNode_New(TOK_SEMICOLON));
+                Out->Type = TOK_SEMICOLON;
                 break;
             case '=':
-                Lexer_AppendToken(Lex, TokNode_New(TOK_EQUAL));
+                Out->Type = TOK_EQUAL;
                 break;
             case '<':
-                Lexer_AppendToken(Lex, TokNode_New(TOK_OANGLE));
+                Out->Type = TOK_OANGLE;
                 break;
             case '>':
-                Lexer_AppendToken(Lex, TokNode_New(TOK_CANGLE));
+                Out->Type = TOK_CANGLE;
                 break;
             case '*':
-                Lexer_AppendToken(Lex, TokNode_New(TOK_STAR));
+                Out->Type = TOK_STAR;
                 break;
             case '&':
-                Lexer_AppendToken(Lex, TokNode_New(TOK_AMPERSAND));
+                Out->Type = TOK_AMPERSAND;
                 break;
             case '+':
-                if (Lex->Input[*pPos + 1] == '+')
+                if (Lexer_CharAt(Lex, *pPos + 1) == '+')
                 {
-                    Lexer_AppendToken(Lex, TokNode_New(TOK_PLUSPLUS));
+                    Out->Type = TOK_PLUSPLUS;
+                    Out->Length = 2;
                     (*pPos)++;
                     break;
                 }
-                Lexer_AppendToken(Lex, TokNode_New(TOK_PLUS));
+                Out->Type = TOK_PLUS;
                 break;
             case '/':
-                if (Lex->Input[*pPos + 1] == '/')
+                if (Lexer_CharAt(Lex, *pPos + 1) == '/')
                 {
                     // handle comments
-                    while ((*pPos < Length) && Lex->Input[*pPos] != '\n')
-                    {
-                        (*pPos)++;
-                    }
-                    break;
+                    *pPos = Scan->FindNewline(Lex->Input, *pPos, Length);
+                    continue;
                 }
-                Lexer_AppendToken(Lex, TokNode_New(TOK_SLASH));
+                Out->Type = TOK_SLASH;
                 break;
             default:
-                break;
+                continue; // not a token, skip it
             }
         }
+
+        (*pPos)++;
+        return true;
     }
+
+    return false;
 }
 
+uint32_t Lexer_FillBatch(Lexer *Lex, TokenBatch *Batch)
+{
+    Batch->Count = 0;
+    while (Batch->Count < TOKEN_BATCH_SIZE && Lexer_Next(Lex, &Batch->Data[Batch->Count]))
+    {
+        Batch->Count++;
+    }
+    return Batch->Count;
+}
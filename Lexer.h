@@ -3,6 +3,9 @@
 #define LEXER_H
 
 #include <stdlib.h>
+#include <stdint.h>
+#include "Intern.h"
+#include "LexerScan.h"
 
 typedef enum
 {
@@ -31,24 +34,57 @@ typedef enum
     TOK_CANGLE,
 } TokType;
 
-typedef struct TokNode TokNode;
-
-struct TokNode
+typedef struct
 {
     TokType Type;
-    char *String;
-    TokNode *Next;
-};
 
+    // span into Lexer::Input, string and char literals dont include the quotes and are still escaped
+    uint32_t Offset;
+    uint32_t Length;
+
+    InternId Id; // identifiers and string literals only
+} Token;
+
+typedef struct
+{
+    Token *Data;
+    size_t Count;
+    size_t Capacity;
+} TokArray;
+
+#define TOKEN_BATCH_SIZE 1024
+
+// a run of tokens handed between threads in one go, Count 0 means the input is done
 typedef struct
 {
-    char *Input;
+    uint32_t Count;
+    Token Data[TOKEN_BATCH_SIZE];
+} TokenBatch;
+
+typedef struct
+{
+    const char *Input; // not null terminated, bounded by Length
+    size_t Length;
     size_t Pos;
-    TokNode *Tokens;
+    InternTable *Interns;
+    const LexerScan *Scan; // picked on first use
 } Lexer;
 
-void Lexer_Tokenize(Lexer *Lex);
+static inline StrView Lexer_TokView(Lexer *Lex, Token *Tok)
+{
+    return (StrView) { Lex->Input + Tok->Offset, Tok->Length };
+}
+
+// scans the next token starting at Lex->Pos, returns false at the end of the input
+bool Lexer_Next(Lexer *Lex, Token *Out);
+
+// lexes up to TOKEN_BATCH_SIZE tokens into Batch and returns how many
+uint32_t Lexer_FillBatch(Lexer *Lex, TokenBatch *Batch);
+
+// decodes escapes in a string/char literal span, writes at most OutLen bytes (no null terminator)
+// and returns the full unescaped length, Out can be NULL to just measure
+size_t Lexer_Unescape(StrView Raw, char *Out, size_t OutLen);
 
-void TokNode_FreeAll(TokNode *List);
+void TokArray_Free(TokArray *Tokens);
 
 #endif // LEXER_H
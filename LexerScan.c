@@ -0,0 +1,227 @@
+#include "LexerScan.h"
+#include <stdint.h>
+#include <string.h>
+#include <stdbool.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define LEXERSCAN_X86
+#include <immintrin.h>
+#endif
+
+// one load per character instead of a chain of range checks
+const unsigned char CharClass[256] = {
+    [' '] = CHAR_SPACE,
+    ['\n'] = CHAR_SPACE,
+    ['\t'] = CHAR_SPACE,
+    ['\r'] = CHAR_SPACE,
+    ['a' ... 'z'] = CHAR_IDENT,
+    ['A' ... 'Z'] = CHAR_IDENT,
+    ['_'] = CHAR_IDENT,
+    ['0' ... '9'] = CHAR_DIGIT,
+};
+
+static size_t Scan_SkipSpaceScalar(const char *Input, size_t Pos, size_t Length)
+{
+    while (Pos < Length && (CharClass[(unsigned char)Input[Pos]] & CHAR_SPACE))
+    {
+        Pos++;
+    }
+    return Pos;
+}
+
+static size_t Scan_SkipIdentScalar(const char *Input, size_t Pos, size_t Length)
+{
+    while (Pos < Length && (CharClass[(unsigned char)Input[Pos]] & (CHAR_IDENT | CHAR_DIGIT)))
+    {
+        Pos++;
+    }
+    return Pos;
+}
+
+static size_t Scan_FindNewlineScalar(const char *Input, size_t Pos, size_t Length)
+{
+    while (Pos < Length && Input[Pos] != '\n')
+    {
+        Pos++;
+    }
+    return Pos;
+}
+
+#ifdef LEXERSCAN_X86
+
+// byte ranges are compared signed, anything >= 0x80 is negative so it never lands in an ascii range
+#define SSE2_IN_RANGE(Chunk, Lo, Hi) \
+    _mm_and_si128(_mm_cmpgt_epi8((Chunk), _mm_set1_epi8((Lo) - 1)), _mm_cmplt_epi8((Chunk), _mm_set1_epi8((Hi) + 1)))
+
+#define AVX2_IN_RANGE(Chunk, Lo, Hi) \
+    _mm256_andnot_si256(_mm256_cmpgt_epi8(_mm256_set1_epi8((Lo)), (Chunk)), _mm256_cmpgt_epi8(_mm256_set1_epi8((Hi) + 1), (Chunk)))
+
+__attribute__((target("sse2")))
+static inline __m128i Sse2_SpaceMask(__m128i Chunk)
+{
+    __m128i Mask = _mm_cmpeq_epi8(Chunk, _mm_set1_epi8(' '));
+    Mask = _mm_or_si128(Mask, _mm_cmpeq_epi8(Chunk, _mm_set1_epi8('\n')));
+    Mask = _mm_or_si128(Mask, _mm_cmpeq_epi8(Chunk, _mm_set1_epi8('\t')));
+    Mask = _mm_or_si128(Mask, _mm_cmpeq_epi8(Chunk, _mm_set1_epi8('\r')));
+    return Mask;
+}
+
+__attribute__((target("sse2")))
+static inline __m128i Sse2_IdentMask(__m128i Chunk)
+{
+    __m128i Lower = _mm_or_si128(Chunk, _mm_set1_epi8(0x20)); // folds A-Z onto a-z
+    __m128i Mask = SSE2_IN_RANGE(Lower, 'a', 'z');
+    Mask = _mm_or_si128(Mask, SSE2_IN_RANGE(Chunk, '0', '9'));
+    Mask = _mm_or_si128(Mask, _mm_cmpeq_epi8(Chunk, _mm_set1_epi8('_')));
+    return Mask;
+}
+
+__attribute__((target("sse2")))
+static size_t Scan_SkipSpaceSse2(const char *Input, size_t Pos, size_t Length)
+{
+    while (Pos + 16 <= Length)
+    {
+        __m128i Chunk = _mm_loadu_si128((const __m128i *)(Input + Pos));
+        uint32_t Stop = ~(uint32_t)_mm_movemask_epi8(Sse2_SpaceMask(Chunk)) & 0xFFFF;
+        if (Stop)
+        {
+            return Pos + __builtin_ctz(Stop);
+        }
+        Pos += 16;
+    }
+    return Scan_SkipSpaceScalar(Input, Pos, Length);
+}
+
+__attribute__((target("sse2")))
+static size_t Scan_SkipIdentSse2(const char *Input, size_t Pos, size_t Length)
+{
+    while (Pos + 16 <= Length)
+    {
+        __m128i Chunk = _mm_loadu_si128((const __m128i *)(Input + Pos));
+        uint32_t Stop = ~(uint32_t)_mm_movemask_epi8(Sse2_IdentMask(Chunk)) & 0xFFFF;
+        if (Stop)
+        {
+            return Pos + __builtin_ctz(Stop);
+        }
+        Pos += 16;
+    }
+    return Scan_SkipIdentScalar(Input, Pos, Length);
+}
+
+__attribute__((target("sse2")))
+static size_t Scan_FindNewlineSse2(const char *Input, size_t Pos, size_t Length)
+{
+    while (Pos + 16 <= Length)
+    {
+        __m128i Chunk = _mm_loadu_si128((const __m128i *)(Input + Pos));
+        uint32_t Stop = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(Chunk, _mm_set1_epi8('\n')));
+        if (Stop)
+        {
+            return Pos + __builtin_ctz(Stop);
+        }
+        Pos += 16;
+    }
+    return Scan_FindNewlineScalar(Input, Pos, Length);
+}
+
+__attribute__((target("avx2")))
+static inline __m256i Avx2_SpaceMask(__m256i Chunk)
+{
+    __m256i Mask = _mm256_cmpeq_epi8(Chunk, _mm256_set1_epi8(' '));
+    Mask = _mm256_or_si256(Mask, _mm256_cmpeq_epi8(Chunk, _mm256_set1_epi8('\n')));
+    Mask = _mm256_or_si256(Mask, _mm256_cmpeq_epi8(Chunk, _mm256_set1_epi8('\t')));
+    Mask = _mm256_or_si256(Mask, _mm256_cmpeq_epi8(Chunk, _mm256_set1_epi8('\r')));
+    return Mask;
+}
+
+__attribute__((target("avx2")))
+static inline __m256i Avx2_IdentMask(__m256i Chunk)
+{
+    __m256i Lower = _mm256_or_si256(Chunk, _mm256_set1_epi8(0x20)); // folds A-Z onto a-z
+    __m256i Mask = AVX2_IN_RANGE(Lower, 'a', 'z');
+    Mask = _mm256_or_si256(Mask, AVX2_IN_RANGE(Chunk, '0', '9'));
+    Mask = _mm256_or_si256(Mask, _mm256_cmpeq_epi8(Chunk, _mm256_set1_epi8('_')));
+    return Mask;
+}
+
+__attribute__((target("avx2")))
+static size_t Scan_SkipSpaceAvx2(const char *Input, size_t Pos, size_t Length)
+{
+    while (Pos + 32 <= Length)
+    {
+        __m256i Chunk = _mm256_loadu_si256((const __m256i *)(Input + Pos));
+        uint32_t Stop = ~(uint32_t)_mm256_movemask_epi8(Avx2_SpaceMask(Chunk));
+        if (Stop)
+        {
+            return Pos + __builtin_ctz(Stop);
+        }
+        Pos += 32;
+    }
+    return Scan_SkipSpaceSse2(Input, Pos, Length);
+}
+
+__attribute__((target("avx2")))
+static size_t Scan_SkipIdentAvx2(const char *Input, size_t Pos, size_t Length)
+{
+    while (Pos + 32 <= Length)
+    {
+        __m256i Chunk = _mm256_loadu_si256((const __m256i *)(Input + Pos));
+        uint32_t Stop = ~(uint32_t)_mm256_movemask_epi8(Avx2_IdentMask(Chunk));
+        if (Stop)
+        {
+            return Pos + __builtin_ctz(Stop);
+        }
+        Pos += 32;
+    }
+    return Scan_SkipIdentSse2(Input, Pos, Length);
+}
+
+__attribute__((target("avx2")))
+static size_t Scan_FindNewlineAvx2(const char *Input, size_t Pos, size_t Length)
+{
+    while (Pos + 32 <= Length)
+    {
+        __m256i Chunk = _mm256_loadu_si256((const __m256i *)(Input + Pos));
+        uint32_t Stop = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(Chunk, _mm256_set1_epi8('\n')));
+        if (Stop)
+        {
+            return Pos + __builtin_ctz(Stop);
+        }
+        Pos += 32;
+    }
+    return Scan_FindNewlineSse2(Input, Pos, Length);
+}
+
+#endif // LEXERSCAN_X86
+
+static const LexerScan ScalarScan = { Scan_SkipSpaceScalar, Scan_SkipIdentScalar, Scan_FindNewlineScalar };
+
+#ifdef LEXERSCAN_X86
+static const LexerScan Sse2Scan = { Scan_SkipSpaceSse2, Scan_SkipIdentSse2, Scan_FindNewlineSse2 };
+static const LexerScan Avx2Scan = { Scan_SkipSpaceAvx2, Scan_SkipIdentAvx2, Scan_FindNewlineAvx2 };
+#endif
+
+const LexerScan *LexerScan_Get(void)
+{
+    // FCC_LEXER_SCAN=scalar|sse2 forces a narrower path, handy for checking they all agree
+    const char *Force = getenv("FCC_LEXER_SCAN");
+
+#ifdef LEXERSCAN_X86
+    bool AllowAvx2 = (Force == NULL);
+    bool AllowSse2 = (Force == NULL) || (strcmp(Force, "sse2") == 0);
+
+    __builtin_cpu_init();
+    if (AllowAvx2 && __builtin_cpu_supports("avx2"))
+    {
+        return &Avx2Scan;
+    }
+    if (AllowSse2 && __builtin_cpu_supports("sse2"))
+    {
+        return &Sse2Scan;
+    }
+#else
+    (void)Force;
+#endif
+
+    return &ScalarScan;
+}
@@ -0,0 +1,29 @@
+#ifndef LEXERSCAN_H
+#define LEXERSCAN_H
+
+#include <stdlib.h>
+
+enum
+{
+    CHAR_SPACE = 1 << 0,
+    CHAR_IDENT = 1 << 1, // can start an identifier
+    CHAR_DIGIT = 1 << 2,
+};
+
+extern const unsigned char CharClass[256];
+
+// all kernels return the first position >= Pos that stops the run (or Length),
+// and never read at or past Length since the input can be an mmap
+typedef size_t (*ScanFn)(const char *Input, size_t Pos, size_t Length);
+
+typedef struct
+{
+    ScanFn SkipSpace; // runs of CHAR_SPACE
+    ScanFn SkipIdent; // runs of CHAR_IDENT | CHAR_DIGIT
+    ScanFn FindNewline; // end of a // comment
+} LexerScan;
+
+// picks avx2/sse2/scalar kernels for the running cpu, every variant gives the same results
+const LexerScan *LexerScan_Get(void);
+
+#endif // LEXERSCAN_H
@@ -1,10 +1,11 @@
 
-#define PROG_LEN 256
-
 #include <stdio.h>
+#include "Source.h"
 #include "Lexer.h"
 #include "Parser.h"
 #include "Compiler.h"
+#include "Pipeline.h"
+#include "Runtime.h"
 
 int main(int argc, const char **argv)
 {
@@ -14,41 +15,51 @@ int main(int argc, const char **argv)
         return 1;
     }
 
-    FILE *f = fopen(argv[1], "rb");
-    if (f == NULL)
+    Source Src;
+    if (!Source_Open(&Src, argv[1]))
     {
         printf("failed to open\n");
         return 1;
     }
 
-    char Buffer[PROG_LEN + 1];
-    size_t BytesRead = fread(Buffer, 1, sizeof(Buffer), f);
-    (void)BytesRead;
-    fclose(f);
+    Runtime Rt;
+    if (!Runtime_Load(&Rt, argv[0]))
+    {
+        printf("failed to load the runtime\n");
+        Source_Close(&Src);
+        return 1;
+    }
 
-    Buffer[sizeof(Buffer) - 1] = 0; // make sure its null terminated
+    InternTable Interns = {0};
 
-    Lexer Lex = { Buffer, 0, NULL };
-    Lexer_Tokenize(&Lex);
+    // tokens are pulled by the parser on demand, no token list is built
+    Lexer Lex = { Src.Data, Src.Length, 0, &Interns, NULL };
 
+    // Token Tok;
+    // while (Lexer_Next(&Lex, &Tok))
     // {
-    //     TokNode *Node = Lex.Tokens;
-    //     while (Node)
-    //     {
-    //         printf("  TokType %i, String '%s'\n", Node->Type, Node->String);
-    //         Node = Node->Next;
-    //     }
+    //     printf("  TokType %i, String '%.*s'\n", Tok.Type, (int)Tok.Length, Lex.Input + Tok.Offset);
     // }
 
-    Parser Parse = { Lex.Tokens, NULL };
-    Parser_Parse(&Parse);
+    AstPool Pool = {0};
+    Parser Parse = { &Lex, {0}, { AST_NULL, AST_NULL }, &Pool, NULL, 0, 0, { {0} }, 0, 0, {0}, false, NULL, 0, 0, {0} };
 
-    Compiler Cmpl = { Parse.Ast, NULL, false, NULL, { {0} }, {0}, 0 };
-    Compiler_Compile(&Cmpl);
+    Compiler Cmpl = { &Pool, &Interns, {0}, false, NULL, {0}, {0}, 0, {0}, NULL, 0, 0, 0, NULL, 0, 0, NULL, 0, 0, NULL, 0, 0, 0, 0, &Rt };
+    Compiler_Begin(&Cmpl); // interns the builtin names, has to happen before any lexer thread starts
+    Pipeline_Compile(&Parse, &Cmpl);
+    Compiler_End(&Cmpl);
 
-    VarNode_FreeAll(Cmpl.Vars);
-    StmtNode_FreeAllRecursive(Parse.Ast);
-    TokNode_FreeAll(Lex.Tokens);
+    free(Cmpl.Fixups);
+    free(Cmpl.Relocs);
+    free(Cmpl.DataRelocs);
+    StringPool_Free(&Cmpl.Strings);
+    free(Cmpl.CallEdges);
+    SymTable_Free(&Cmpl.Syms);
+    Parser_Free(&Parse);
+    AstPool_Free(&Pool); // the whole ast in one go
+    InternTable_Free(&Interns);
+    Runtime_Free(&Rt);
+    Source_Close(&Src);
 
     if (Cmpl.HasErrors)
     {
@@ -1,193 +1,518 @@
-
 #include <stdio.h>
 #include <string.h>
 #include <stdbool.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <unistd.h>
 #include "Parser.h"
 
-void StmtNode_FreeAllRecursive(StmtNode *List)
+// doubles *Capacity until Count + Extra fits, index 0 is kept free as the null node for the node arrays
+static void *AstPool_Grow(void *Data, uint32_t Count, uint32_t Extra, uint32_t *Capacity, size_t ElemSize)
 {
-    if (List == NULL)
+    if (Count + Extra <= *Capacity)
+    {
+        return Data;
+    }
+
+    if (*Capacity == 0)
+    {
+        *Capacity = 256;
+    }
+    while (Count + Extra > *Capacity)
+    {
+        *Capacity *= 2;
+    }
+    return realloc(Data, *Capacity * ElemSize);
+}
+
+ExprRef AstPool_NewExpr(AstPool *Pool, ExprType Type)
+{
+    if (Pool->ExprCount == 0)
+    {
+        Pool->ExprCount = 1; // AST_NULL
+    }
+
+    Pool->Exprs = AstPool_Grow(Pool->Exprs, Pool->ExprCount, 1, &Pool->ExprCapacity, sizeof(Expr_t));
+
+    ExprRef Ref = Pool->ExprCount++;
+    Expr_t *Expr = Ast_Expr(Pool, Ref);
+    memset(Expr, 0, sizeof(Expr_t));
+    Expr->Type = Type;
+    return Ref;
+}
+
+StmtRef AstPool_NewStmt(AstPool *Pool, StmtType Type)
+{
+    if (Pool->StmtCount == 0)
+    {
+        Pool->StmtCount = 1; // AST_NULL
+    }
+
+    Pool->Stmts = AstPool_Grow(Pool->Stmts, Pool->StmtCount, 1, &Pool->StmtCapacity, sizeof(StmtNode));
+
+    StmtRef Ref = Pool->StmtCount++;
+    StmtNode *Stmt = Ast_Stmt(Pool, Ref);
+    memset(Stmt, 0, sizeof(StmtNode));
+    Stmt->Type = Type;
+    return Ref;
+}
+
+void AstPool_Reset(AstPool *Pool)
+{
+    Pool->ExprCount = 0;
+    Pool->StmtCount = 0;
+    Pool->ArgCount = 0;
+    Pool->ParamCount = 0;
+}
+
+void AstPool_Free(AstPool *Pool)
+{
+    free(Pool->Exprs);
+    free(Pool->Stmts);
+    free(Pool->Args);
+    free(Pool->Params);
+    memset(Pool, 0, sizeof(AstPool));
+}
+
+void StmtList_Append(AstPool *Pool, StmtList *List, StmtRef NewNode)
+{
+    if (NewNode == AST_NULL)
     {
         return;
     }
 
-    StmtNode *Node = List;
-    while (Node)
+    if (List->Head == AST_NULL)
     {
-        StmtNode *OldNode = Node;
+        List->Head = NewNode;
+    }
+    else
+    {
+        Ast_Stmt(Pool, List->Tail)->Next = NewNode;
+    }
+    List->Tail = NewNode;
+}
+
+static AstMark AstPool_Mark(AstPool *Pool)
+{
+    // AST_NULL has to be taken before anything is counted from here
+    Pool->ExprCount = (Pool->ExprCount == 0) ? 1 : Pool->ExprCount;
+    Pool->StmtCount = (Pool->StmtCount == 0) ? 1 : Pool->StmtCount;
+
+    return (AstMark) { Pool->ExprCount, Pool->StmtCount, Pool->ArgCount, Pool->ParamCount };
+}
+
+static inline uint32_t AstPool_Rebase(uint32_t Ref, uint32_t From, uint32_t To)
+{
+    return (Ref == AST_NULL) ? AST_NULL : (Ref - From + To);
+}
 
-        switch (OldNode->Type)
+// copies the nodes Src allocated between From and To onto the end of Dst and fixes up every ref in them,
+// returns where Head ended up
+static StmtRef AstPool_Splice(AstPool *Dst, AstPool *Src, AstMark From, AstMark To, StmtRef Head)
+{
+    AstMark Base = AstPool_Mark(Dst);
+    uint32_t ExprCount = To.Expr - From.Expr;
+    uint32_t StmtCount = To.Stmt - From.Stmt;
+    uint32_t ArgCount = To.Arg - From.Arg;
+    uint32_t ParamCount = To.Param - From.Param;
+
+    Dst->Exprs = AstPool_Grow(Dst->Exprs, Dst->ExprCount, ExprCount, &Dst->ExprCapacity, sizeof(Expr_t));
+    Dst->Stmts = AstPool_Grow(Dst->Stmts, Dst->StmtCount, StmtCount, &Dst->StmtCapacity, sizeof(StmtNode));
+    Dst->Args = AstPool_Grow(Dst->Args, Dst->ArgCount, ArgCount, &Dst->ArgCapacity, sizeof(ExprRef));
+    Dst->Params = AstPool_Grow(Dst->Params, Dst->ParamCount, ParamCount, &Dst->ParamCapacity, sizeof(ParamDesc));
+
+    // empty ranges can come from pools that never allocated, so theres nothing to copy from
+    if (ExprCount) memcpy(&Dst->Exprs[Base.Expr], &Src->Exprs[From.Expr], ExprCount * sizeof(Expr_t));
+    if (StmtCount) memcpy(&Dst->Stmts[Base.Stmt], &Src->Stmts[From.Stmt], StmtCount * sizeof(StmtNode));
+    if (ArgCount) memcpy(&Dst->Args[Base.Arg], &Src->Args[From.Arg], ArgCount * sizeof(ExprRef));
+    if (ParamCount) memcpy(&Dst->Params[Base.Param], &Src->Params[From.Param], ParamCount * sizeof(ParamDesc));
+
+    #define REBASE_EXPR(Ref) (Ref) = AstPool_Rebase((Ref), From.Expr, Base.Expr)
+    #define REBASE_STMT(Ref) (Ref) = AstPool_Rebase((Ref), From.Stmt, Base.Stmt)
+
+    for (uint32_t i = 0; i < ExprCount; i++)
+    {
+        Expr_t *Expr = &Dst->Exprs[Base.Expr + i];
+        switch (Expr->Type)
         {
-        case STMT_EXPR:
-            Expr_FreeRecursive(OldNode->As.Expr);
+        case EXPR_CALL:
+            REBASE_EXPR(Expr->As.Call.Callee);
+            Expr->As.Call.FirstArg = Expr->As.Call.FirstArg - From.Arg + Base.Arg;
             break;
-
-        case STMT_WHILE:
-            Expr_FreeRecursive(OldNode->As.While.Condition);
-            StmtNode_FreeAllRecursive(OldNode->As.While.Body);
+        case EXPR_ASSIGN:
+            REBASE_EXPR(Expr->As.Assign.Target);
+            REBASE_EXPR(Expr->As.Assign.Expr);
             break;
-
-        case STMT_FUNC:
-            free(OldNode->As.Func.Name);
-            StmtNode_FreeAllRecursive(OldNode->As.Func.Body);
+        case EXPR_ADDRESSOF:
+            REBASE_EXPR(Expr->As.AddressOf);
             break;
-
-        case STMT_VARDECL:
-            Expr_FreeRecursive(OldNode->As.VarDecl.Init);
+        case EXPR_DEREF:
+            REBASE_EXPR(Expr->As.Deref);
+            break;
+        case EXPR_INC:
+            REBASE_EXPR(Expr->As.Inc);
+            break;
+        case EXPR_BINARYOP:
+            REBASE_EXPR(Expr->As.BinaryOp.A);
+            REBASE_EXPR(Expr->As.BinaryOp.B);
             break;
+        default:
+            break;
+        }
+    }
+
+    for (uint32_t i = 0; i < ArgCount; i++)
+    {
+        REBASE_EXPR(Dst->Args[Base.Arg + i]);
+    }
 
+    for (uint32_t i = 0; i < StmtCount; i++)
+    {
+        StmtNode *Stmt = &Dst->Stmts[Base.Stmt + i];
+        switch (Stmt->Type)
+        {
+        case STMT_EXPR:
+            REBASE_EXPR(Stmt->As.Expr);
+            break;
+        case STMT_FUNC:
+            REBASE_STMT(Stmt->As.Func.Body);
+            Stmt->As.Func.FirstParam = Stmt->As.Func.FirstParam - From.Param + Base.Param;
+            break;
         case STMT_RETURN:
-            Expr_FreeRecursive(OldNode->As.Return);
+            REBASE_EXPR(Stmt->As.Return);
             break;
-
-        default:
+        case STMT_VARDECL:
+            REBASE_EXPR(Stmt->As.VarDecl.Init);
+            break;
+        case STMT_WHILE:
+            REBASE_EXPR(Stmt->As.While.Condition);
+            REBASE_STMT(Stmt->As.While.Body);
             break;
         }
+        REBASE_STMT(Stmt->Next);
+    }
+
+    #undef REBASE_EXPR
+    #undef REBASE_STMT
+
+    Dst->ExprCount += ExprCount;
+    Dst->StmtCount += StmtCount;
+    Dst->ArgCount += ArgCount;
+    Dst->ParamCount += ParamCount;
 
-        Node = OldNode->Next;
-        free(OldNode);
+    return AstPool_Rebase(Head, From.Stmt, Base.Stmt);
+}
+
+static unsigned int Parser_SpanToNumber(StrView View)
+{
+    unsigned int Number = 0;
+    for (size_t i = 0; i < View.Length && View.Data[i] >= '0' && View.Data[i] <= '9'; i++)
+    {
+        Number = (Number * 10) + (View.Data[i] - '0');
     }
+    return Number;
 }
 
-void Expr_FreeRecursive(Expr_t *Expr)
+static bool Parser_PullTok(Parser *Parse, Token *Out)
 {
-    if (Expr == NULL)
+    TokSource *Src = &Parse->Source;
+
+    if (Src->Replay)
     {
-        return;
+        if (Src->ReplayPos == Src->ReplayCount)
+        {
+            return false;
+        }
+        *Out = Src->Replay[Src->ReplayPos++];
+        return true;
     }
 
-    switch (Expr->Type)
+    if (Src->Ring)
     {
-    case EXPR_CALL:
-        Expr_FreeRecursive(Expr->As.Call.Callee);
-        for (size_t i = 0; i < (sizeof(Expr->As.Call.Arguments) / sizeof(Expr->As.Call.Arguments[0])); i++)
+        while (Src->Batch == NULL || Src->BatchPos == Src->Batch->Count)
         {
-            Expr_t *Arg = Expr->As.Call.Arguments[i];
-            if (Arg == NULL)
+            if (Src->Batch)
             {
-                break;
+                if (Src->Batch->Count == 0)
+                {
+                    return false; // end of input, the slot is kept so later pulls see it too
+                }
+                SpscRing_Pop(Src->Ring);
             }
-            Expr_FreeRecursive(Arg);
+            Src->Batch = SpscRing_PopSlot(Src->Ring);
+            Src->BatchPos = 0;
         }
-        break;
+        *Out = Src->Batch->Data[Src->BatchPos++];
+        return true;
+    }
 
-    case EXPR_ASSIGN:
-        Expr_FreeRecursive(Expr->As.Assign.Target);
-        Expr_FreeRecursive(Expr->As.Assign.Expr);
-        break;
+    return Lexer_Next(Parse->Lex, Out);
+}
+
+// Offset 0 is the current token, pulls from the token source until the ring holds Offset + 1 tokens
+Token *Parser_PeekTokAhead(Parser *Parse, size_t Offset)
+{
+    static Token EofTok = { (TokType)-1, 0, 0, INTERN_NONE }; // never written, workers share it
 
-    case EXPR_ADDRESSOF:
-        Expr_FreeRecursive(Expr->As.AddressOf);
-        break;
+    while (Parse->AheadCount <= Offset)
+    {
+        if (Parse->AheadCount == PARSER_LOOKAHEAD)
+        {
+            return &EofTok; // cant look that far ahead
+        }
 
-    case EXPR_INC:
-        Expr_FreeRecursive(Expr->As.Inc);
-        break;
+        Token *Slot = &Parse->Ahead[(Parse->AheadStart + Parse->AheadCount) % PARSER_LOOKAHEAD];
+        if (!Parser_PullTok(Parse, Slot))
+        {
+            return &EofTok;
+        }
+        Parse->AheadCount++;
+    }
 
-    case EXPR_DEREF:
-        Expr_FreeRecursive(Expr->As.Deref);
-        break;
+    return &Parse->Ahead[(Parse->AheadStart + Offset) % PARSER_LOOKAHEAD];
+}
 
-    case EXPR_BINARYOP:
-        Expr_FreeRecursive(Expr->As.BinaryOp.A);
-        Expr_FreeRecursive(Expr->As.BinaryOp.B);
-        break;
+Token *Parser_PeekTok(Parser *Parse)
+{
+    return Parser_PeekTokAhead(Parse, 0);
+}
 
-    default:
-        break;
+static inline bool Parser_AtEnd(Parser *Parse)
+{
+    return Parse->AheadCount == 0 && Parser_PeekTok(Parse)->Type == (TokType)-1;
+}
+
+// the returned token stays valid until the next consume
+Token *Parser_ConsumeTok(Parser *Parse)
+{
+    if (Parser_AtEnd(Parse))
+    {
+        return NULL;
     }
 
-    free(Expr);
+    Parse->Current = Parse->Ahead[Parse->AheadStart];
+    Parse->AheadStart = (Parse->AheadStart + 1) % PARSER_LOOKAHEAD;
+    Parse->AheadCount--;
+    return &Parse->Current;
 }
 
-void StmtNode_Append(StmtNode *List, StmtNode *NewNode)
+Token *Parser_ExpectTok(Parser *Parse, TokType Type)
 {
-    if (List == NULL)
+    Token *Tok = Parser_ConsumeTok(Parse);
+    if (Tok == NULL)
     {
-        return;
+        return NULL;
     }
-    StmtNode *Node = List;
-    while (Node->Next)
+
+    if (Tok->Type != Type)
     {
-        Node = Node->Next;
+        printf("expected %i, but got %i\n", Type, Tok->Type);
     }
-    Node->Next = NewNode;
+
+    return Tok;
 }
 
-void Parser_AppendStmt(Parser *Parse, StmtNode *NewNode)
+#define PARSER_PARALLEL_MIN_TOKENS (16 * 1024) // below this starting threads costs more than it saves
+#define PARSER_MAX_THREADS 64
+
+typedef struct
+{
+    Parser *Top; // only read
+    atomic_uint *NextJob;
+    uint32_t Index;
+
+    Parser Parse;
+    AstPool Pool; // every body this worker parses, spliced into the top level pool afterwards
+} ParseWorker;
+
+static void *Parser_BodyWorker(void *Arg)
 {
-    if (NewNode == NULL)
+    ParseWorker *Worker = Arg;
+    Parser *Top = Worker->Top;
+
+    while (true)
     {
-        return;
+        uint32_t Index = atomic_fetch_add(Worker->NextJob, 1);
+        if (Index >= Top->JobCount)
+        {
+            break;
+        }
+
+        // replays the tokens the top level pass saved, nothing is lexed twice
+        BodyJob *Job = &Top->Jobs[Index];
+        Worker->Parse.Source.Replay = &Top->BodyToks.Data[Job->FirstTok];
+        Worker->Parse.Source.ReplayCount = Job->TokCount;
+        Worker->Parse.Source.ReplayPos = 0;
+        Worker->Parse.AheadStart = 0;
+        Worker->Parse.AheadCount = 0;
+
+        Job->Worker = Worker->Index;
+        Job->From = AstPool_Mark(&Worker->Pool);
+
+        StmtList Body = { AST_NULL, AST_NULL };
+        while (!Parser_AtEnd(&Worker->Parse))
+        {
+            StmtRef Stmt = Parser_ParseStmt(&Worker->Parse);
+            StmtList_Append(&Worker->Pool, &Body, Stmt);
+        }
+
+        Job->To = AstPool_Mark(&Worker->Pool);
+        Job->Body = Body.Head;
     }
 
-    if (Parse->Ast == NULL)
+    return NULL;
+}
+
+static uint32_t Parser_ThreadCount(Parser *Parse)
+{
+    size_t Tokens = Parse->BodyToks.Count;
+
+    long Count = sysconf(_SC_NPROCESSORS_ONLN);
+
+    // FCC_PARSE_THREADS=n forces n threads no matter how small the input is
+    const char *Env = getenv("FCC_PARSE_THREADS");
+    if (Env)
     {
-        Parse->Ast = NewNode;
+        Count = atol(Env);
     }
-    else
+    else if (Tokens < PARSER_PARALLEL_MIN_TOKENS)
     {
-        StmtNode_Append(Parse->Ast, NewNode);
+        Count = 1;
     }
+
+    if (Count > PARSER_MAX_THREADS) Count = PARSER_MAX_THREADS;
+    if (Count > (long)Parse->JobCount) Count = Parse->JobCount;
+    if (Count < 1) Count = 1;
+    return (uint32_t)Count;
 }
 
-TokNode *Parser_ConsumeTok(Parser *Parse)
+// bodies dont depend on each other, so each worker parses whole bodies into its own pool
+// and the results are stitched back onto their function nodes in source order
+static void Parser_ParseBodies(Parser *Parse)
 {
-    if (Parse->Tok == NULL)
+    if (Parse->JobCount == 0)
     {
-        return NULL;
+        return;
     }
 
-    TokNode *OldNode = Parse->Tok;
-    Parse->Tok = OldNode->Next;
-    return OldNode;
-}
+    uint32_t ThreadCount = Parser_ThreadCount(Parse);
+    ParseWorker *Workers = calloc(ThreadCount, sizeof(ParseWorker));
+    pthread_t *Threads = calloc(ThreadCount, sizeof(pthread_t));
+    bool *Started = calloc(ThreadCount, sizeof(bool));
+    atomic_uint NextJob = 0;
 
-TokNode *Parser_ExpectTok(Parser *Parse, TokType Type)
-{
-    if (Parse->Tok == NULL)
+    for (uint32_t i = 0; i < ThreadCount; i++)
     {
-        return NULL;
+        ParseWorker *Worker = &Workers[i];
+        Worker->Top = Parse;
+        Worker->NextJob = &NextJob;
+        Worker->Index = i;
+        Worker->Parse.Lex = Parse->Lex; // only for the source text, the tokens come from BodyToks
+        Worker->Parse.Pool = &Worker->Pool;
+    }
+
+    // the calling thread is worker 0, if a thread fails to start the others just take its share
+    for (uint32_t i = 1; i < ThreadCount; i++)
+    {
+        Started[i] = pthread_create(&Threads[i], NULL, Parser_BodyWorker, &Workers[i]) == 0;
+    }
+    Parser_BodyWorker(&Workers[0]);
+
+    for (uint32_t i = 1; i < ThreadCount; i++)
+    {
+        if (Started[i])
+        {
+            pthread_join(Threads[i], NULL);
+        }
     }
 
-    TokNode *OldNode = Parse->Tok;
+    for (uint32_t i = 0; i < Parse->JobCount; i++)
+    {
+        BodyJob *Job = &Parse->Jobs[i];
+        AstPool *Src = &Workers[Job->Worker].Pool;
+        StmtRef Body = AstPool_Splice(Parse->Pool, Src, Job->From, Job->To, Job->Body);
+        Ast_Stmt(Parse->Pool, Job->Func)->As.Func.Body = Body;
+    }
 
-    if (OldNode->Type != Type)
+    for (uint32_t i = 0; i < ThreadCount; i++)
     {
-        printf("expected %i, but got %i\n", Type, OldNode->Type);
+        Parser_Free(&Workers[i].Parse);
+        AstPool_Free(&Workers[i].Pool);
     }
+    free(Workers);
+    free(Threads);
+    free(Started);
 
-    Parse->Tok = OldNode->Next;
-    return OldNode;
+    Parse->JobCount = 0;
+    Parse->BodyToks.Count = 0;
 }
 
-TokNode *Parser_PeekTok(Parser *Parse)
+// called right after the opening brace, saves the tokens up to the matching one and queues them
+static void Parser_DeferBody(Parser *Parse, StmtRef FuncNode)
 {
-    static TokNode EofTok = {0};
-    EofTok.Type = -1;
-    if (Parse->Tok == NULL)
-    {
-        return &EofTok;
-    }
-    else
+    TokArray *Toks = &Parse->BodyToks;
+    uint32_t FirstTok = Toks->Count;
+
+    uint32_t Depth = 1;
+    Token *Tok;
+    while ((Tok = Parser_ConsumeTok(Parse)) != NULL)
     {
-        return Parse->Tok;
+        if (Tok->Type == TOK_OBRACE)
+        {
+            Depth++;
+        }
+        else if (Tok->Type == TOK_CBRACE && --Depth == 0)
+        {
+            break;
+        }
+
+        if (Toks->Count == Toks->Capacity)
+        {
+            Toks->Capacity = (Toks->Capacity == 0) ? 4096 : (Toks->Capacity * 2);
+            Toks->Data = realloc(Toks->Data, Toks->Capacity * sizeof(Token));
+        }
+        Toks->Data[Toks->Count++] = *Tok;
     }
+
+    Parse->Jobs = AstPool_Grow(Parse->Jobs, Parse->JobCount, 1, &Parse->JobCapacity, sizeof(BodyJob));
+    Parse->Jobs[Parse->JobCount++] = (BodyJob) { .Func = FuncNode, .FirstTok = FirstTok, .TokCount = Toks->Count - FirstTok };
 }
 
-void Parser_Parse(Parser *Parse)
+StmtRef Parser_ParseBatch(Parser *Parse)
 {
-    while (Parse->Tok)
+    Parse->Ast = (StmtList) { AST_NULL, AST_NULL };
+    Parse->DeferBodies = true;
+
+    while (!Parser_AtEnd(Parse) && Parse->BodyToks.Count < PARSER_BATCH_TOKENS)
     {
-        StmtNode *Stmt = Parser_ParseStmt(Parse);
-        Parser_AppendStmt(Parse, Stmt);
+        StmtRef Stmt = Parser_ParseStmt(Parse);
+        StmtList_Append(Parse->Pool, &Parse->Ast, Stmt);
     }
+
+    Parse->DeferBodies = false;
+    Parser_ParseBodies(Parse);
+    return Parse->Ast.Head;
+}
+
+void Parser_Free(Parser *Parse)
+{
+    free(Parse->ArgStack);
+    Parse->ArgStack = NULL;
+    Parse->ArgStackCount = 0;
+    Parse->ArgStackCapacity = 0;
+
+    free(Parse->Jobs);
+    Parse->Jobs = NULL;
+    Parse->JobCount = 0;
+    Parse->JobCapacity = 0;
+
+    TokArray_Free(&Parse->BodyToks);
 }
 
 TypeDesc Parser_ParseType(Parser *Parse)
 {
     TypeDesc Type = {0};
-    TokNode *Node = Parser_PeekTok(Parse);
+    Token *Node = Parser_PeekTok(Parse);
 
     switch (Node->Type)
     {
@@ -228,51 +553,51 @@ TypeDesc Parser_ParseType(Parser *Parse)
     return Type;
 }
 
-Expr_t *Parser_ParseExpr(Parser *Parse)
+ExprRef Parser_ParseExpr(Parser *Parse)
 {
-    Expr_t *Expr = Parser_ParsePrimary(Parse);
+    ExprRef Expr = Parser_ParsePrimary(Parse);
 
     if (Parser_PeekTok(Parse)->Type == TOK_PLUS)
     {
         Parser_ConsumeTok(Parse);
-        Expr_t *AddExpr = malloc(sizeof(Expr_t));
-        AddExpr->Type = EXPR_BINARYOP;
-        AddExpr->As.BinaryOp.Op = OP_ADD;
-        AddExpr->As.BinaryOp.A = Expr;
-        AddExpr->As.BinaryOp.B = Parser_ParsePrimary(Parse);
+        ExprRef B = Parser_ParsePrimary(Parse);
+
+        ExprRef AddExpr = AstPool_NewExpr(Parse->Pool, EXPR_BINARYOP);
+        Ast_Expr(Parse->Pool, AddExpr)->As.BinaryOp.Op = OP_ADD;
+        Ast_Expr(Parse->Pool, AddExpr)->As.BinaryOp.A = Expr;
+        Ast_Expr(Parse->Pool, AddExpr)->As.BinaryOp.B = B;
         Expr = AddExpr;
     }
     else if (Parser_PeekTok(Parse)->Type == TOK_OANGLE)
     {
         Parser_ConsumeTok(Parse);
-        Expr_t *LessThanExpr = malloc(sizeof(Expr_t));
-        LessThanExpr->Type = EXPR_BINARYOP;
-        LessThanExpr->As.BinaryOp.Op = OP_LESSTHAN;
-        LessThanExpr->As.BinaryOp.A = Expr;
-        LessThanExpr->As.BinaryOp.B = Parser_ParsePrimary(Parse);
+        ExprRef B = Parser_ParsePrimary(Parse);
+
+        ExprRef LessThanExpr = AstPool_NewExpr(Parse->Pool, EXPR_BINARYOP);
+        Ast_Expr(Parse->Pool, LessThanExpr)->As.BinaryOp.Op = OP_LESSTHAN;
+        Ast_Expr(Parse->Pool, LessThanExpr)->As.BinaryOp.A = Expr;
+        Ast_Expr(Parse->Pool, LessThanExpr)->As.BinaryOp.B = B;
         Expr = LessThanExpr;
     }
 
     return Expr;
 }
 
-Expr_t *Parser_ParsePrimary(Parser *Parse)
+ExprRef Parser_ParsePrimary(Parser *Parse)
 {
-    Expr_t *Expr = Parser_ParseSecondary(Parse);
+    ExprRef Expr = Parser_ParseSecondary(Parse);
 
     if (Parser_PeekTok(Parse)->Type == TOK_OPAREN)
     {
         Parser_ConsumeTok(Parse);
 
-        Expr_t *CallExpr = malloc(sizeof(Expr_t));
-        CallExpr->Type = EXPR_CALL;
-        CallExpr->As.Call.Callee = Expr;
-
-        memset(&CallExpr->As.Call.Arguments, 0, sizeof(CallExpr->As.Call.Arguments));
-
-        for (size_t i = 0; (Parser_PeekTok(Parse)->Type != TOK_CPAREN); i++)
+        uint32_t ArgBase = Parse->ArgStackCount;
+        while (Parser_PeekTok(Parse)->Type != TOK_CPAREN)
         {
-            CallExpr->As.Call.Arguments[i] = Parser_ParseExpr(Parse);
+            ExprRef Arg = Parser_ParseExpr(Parse);
+
+            Parse->ArgStack = AstPool_Grow(Parse->ArgStack, Parse->ArgStackCount, 1, &Parse->ArgStackCapacity, sizeof(ExprRef));
+            Parse->ArgStack[Parse->ArgStackCount++] = Arg;
 
             if (Parser_PeekTok(Parse)->Type != TOK_CPAREN)
             {
@@ -281,15 +606,30 @@ Expr_t *Parser_ParsePrimary(Parser *Parse)
         }
 
         Parser_ConsumeTok(Parse);
+
+        // all nested calls are done, so this call's arguments can go in as one range
+        AstPool *Pool = Parse->Pool;
+        uint32_t ArgCount = Parse->ArgStackCount - ArgBase;
+        uint32_t FirstArg = Pool->ArgCount;
+        Pool->Args = AstPool_Grow(Pool->Args, Pool->ArgCount, ArgCount, &Pool->ArgCapacity, sizeof(ExprRef));
+        memcpy(&Pool->Args[FirstArg], &Parse->ArgStack[ArgBase], ArgCount * sizeof(ExprRef));
+        Pool->ArgCount += ArgCount;
+        Parse->ArgStackCount = ArgBase;
+
+        ExprRef CallExpr = AstPool_NewExpr(Pool, EXPR_CALL);
+        Ast_Expr(Pool, CallExpr)->As.Call.Callee = Expr;
+        Ast_Expr(Pool, CallExpr)->As.Call.FirstArg = FirstArg;
+        Ast_Expr(Pool, CallExpr)->As.Call.ArgCount = ArgCount;
         Expr = CallExpr;
     }
     else if (Parser_PeekTok(Parse)->Type == TOK_EQUAL)
     {
         Parser_ConsumeTok(Parse);
-        Expr_t *AssignExpr = malloc(sizeof(Expr_t));
-        AssignExpr->Type = EXPR_ASSIGN;
-        AssignExpr->As.Assign.Target = Expr;
-        AssignExpr->As.Assign.Expr = Parser_ParseExpr(Parse);
+        ExprRef Value = Parser_ParseExpr(Parse);
+
+        ExprRef AssignExpr = AstPool_NewExpr(Parse->Pool, EXPR_ASSIGN);
+        Ast_Expr(Parse->Pool, AssignExpr)->As.Assign.Target = Expr;
+        Ast_Expr(Parse->Pool, AssignExpr)->As.Assign.Expr = Value;
         
         Expr = AssignExpr;
     }
@@ -297,15 +637,20 @@ Expr_t *Parser_ParsePrimary(Parser *Parse)
     return Expr;
 }
 
-Expr_t *Parser_ParseSecondary(Parser *Parse)
+ExprRef Parser_ParseSecondary(Parser *Parse)
 {
-    TokNode *Node = Parser_ConsumeTok(Parse);
+    Token *Node = Parser_ConsumeTok(Parse);
+    if (Node == NULL)
+    {
+        printf("expected an expression\n");
+        return AST_NULL;
+    }
 
     switch (Node->Type)
     {
     case TOK_OPAREN: // TODO: "(type)expr" casting
     {
-        Expr_t *Expr = Parser_ParseExpr(Parse);
+        ExprRef Expr = Parser_ParseExpr(Parse);
         Parser_ExpectTok(Parse, TOK_CPAREN);
         return Expr;
     }
@@ -313,91 +658,83 @@ Expr_t *Parser_ParseSecondary(Parser *Parse)
 
     case TOK_NUMBERLIT:
     {
-        Expr_t *Expr = malloc(sizeof(Expr_t));
-        memset(Expr, 0, sizeof(Expr_t));
-        Expr->Type = EXPR_NUMBERLIT;
-        Expr->As.NumberLit = atoi(Node->String);
+        ExprRef Expr = AstPool_NewExpr(Parse->Pool, EXPR_NUMBERLIT);
+        Ast_Expr(Parse->Pool, Expr)->As.NumberLit = Parser_SpanToNumber(Lexer_TokView(Parse->Lex, Node));
         return Expr;
     }
     break;
 
     case TOK_CHARLIT:
     {
-        Expr_t *Expr = malloc(sizeof(Expr_t));
-        memset(Expr, 0, sizeof(Expr_t));
-        Expr->Type = EXPR_CHARLIT;
-        Expr->As.CharLit = *(Node->String);
+        char c = 0;
+        Lexer_Unescape(Lexer_TokView(Parse->Lex, Node), &c, 1);
+
+        ExprRef Expr = AstPool_NewExpr(Parse->Pool, EXPR_CHARLIT);
+        Ast_Expr(Parse->Pool, Expr)->As.CharLit = c;
         return Expr;
     }
     break;
 
     case TOK_STRINGLIT:
     {
-        Expr_t *Expr = malloc(sizeof(Expr_t));
-        memset(Expr, 0, sizeof(Expr_t));
-        Expr->Type = EXPR_STRINGLIT;
-        Expr->As.StringLit = Node->String;
+        ExprRef Expr = AstPool_NewExpr(Parse->Pool, EXPR_STRINGLIT);
+        Ast_Expr(Parse->Pool, Expr)->As.StringLit = Node->Id; // unescaped by the compiler
         return Expr;
     }
     break;
     
     case TOK_IDENT:
     {
-        Expr_t *Expr = malloc(sizeof(Expr_t));
-        memset(Expr, 0, sizeof(Expr_t));
-        Expr->Type = EXPR_IDENT;
-        Expr->As.Ident = Node->String;
+        ExprRef Expr = AstPool_NewExpr(Parse->Pool, EXPR_IDENT);
+        Ast_Expr(Parse->Pool, Expr)->As.Ident = Node->Id;
         return Expr;
     }
     break;
 
     case TOK_AMPERSAND:
     {
-        Expr_t *Expr = malloc(sizeof(Expr_t));
-        memset(Expr, 0, sizeof(Expr_t));
-        Expr->Type = EXPR_ADDRESSOF;
-        Expr->As.AddressOf = Parser_ParseSecondary(Parse);
+        ExprRef Operand = Parser_ParseSecondary(Parse);
+        ExprRef Expr = AstPool_NewExpr(Parse->Pool, EXPR_ADDRESSOF);
+        Ast_Expr(Parse->Pool, Expr)->As.AddressOf = Operand;
         return Expr;
     }
     break;
 
     case TOK_PLUSPLUS:
     {
-        Expr_t *Expr = malloc(sizeof(Expr_t));
-        memset(Expr, 0, sizeof(Expr_t));
-        Expr->Type = EXPR_INC;
-        Expr->As.Inc = Parser_ParseSecondary(Parse);
+        ExprRef Operand = Parser_ParseSecondary(Parse);
+        ExprRef Expr = AstPool_NewExpr(Parse->Pool, EXPR_INC);
+        Ast_Expr(Parse->Pool, Expr)->As.Inc = Operand;
         return Expr;
     }
     break;
 
     case TOK_STAR:
     {
-        Expr_t *Expr = malloc(sizeof(Expr_t));
-        memset(Expr, 0, sizeof(Expr_t));
-        Expr->Type = EXPR_DEREF;
-        Expr->As.Deref = Parser_ParseSecondary(Parse);
+        ExprRef Operand = Parser_ParseSecondary(Parse);
+        ExprRef Expr = AstPool_NewExpr(Parse->Pool, EXPR_DEREF);
+        Ast_Expr(Parse->Pool, Expr)->As.Deref = Operand;
         return Expr;
     }
     break;
 
     default:
         printf("expected an expression\n");
-        return NULL;
+        return AST_NULL;
     }
 }
 
-StmtNode *Parser_ParseStmt(Parser *Parse)
+StmtRef Parser_ParseStmt(Parser *Parse)
 {
-    if (Parse->Tok == NULL)
+    if (Parser_AtEnd(Parse))
     {
-        return NULL;
+        return AST_NULL;
     }
 
     TypeDesc Type = Parser_ParseType(Parse);
     if (Type.Type != TYPE_NOT_A_TYPE)
     {
-        if (Parser_PeekTok(Parse)->Next->Type == TOK_OPAREN)
+        if (Parser_PeekTokAhead(Parse, 1)->Type == TOK_OPAREN)
         {
             return Parser_ParseFuncStmt(Parse, &Type);
         }
@@ -407,7 +744,7 @@ StmtNode *Parser_ParseStmt(Parser *Parse)
         }
     }
 
-    TokNode *Node = Parser_PeekTok(Parse);
+    Token *Node = Parser_PeekTok(Parse);
 
     switch (Node->Type)
     {
@@ -416,21 +753,19 @@ StmtNode *Parser_ParseStmt(Parser *Parse)
     {
         Parser_ConsumeTok(Parse);
 
-        StmtNode *ReturnStmt = malloc(sizeof(StmtNode));
-        memset(ReturnStmt, 0, sizeof(StmtNode));
-        ReturnStmt->Type = STMT_RETURN;
-        ReturnStmt->Next = NULL;
-
+        ExprRef Value = AST_NULL;
         if (Parser_PeekTok(Parse)->Type == TOK_SEMICOLON)
         {
-            ReturnStmt->As.Return = NULL;
             Parser_ConsumeTok(Parse);
         }
         else
         {
-            ReturnStmt->As.Return = Parser_ParseExpr(Parse);
+            Value = Parser_ParseExpr(Parse);
             Parser_ExpectTok(Parse, TOK_SEMICOLON);
         }
+
+        StmtRef ReturnStmt = AstPool_NewStmt(Parse->Pool, STMT_RETURN);
+        Ast_Stmt(Parse->Pool, ReturnStmt)->As.Return = Value;
         
         return ReturnStmt;
     }
@@ -441,76 +776,68 @@ StmtNode *Parser_ParseStmt(Parser *Parse)
         Parser_ConsumeTok(Parse);
         
         Parser_ExpectTok(Parse, TOK_OPAREN);
-        Expr_t *Condition = Parser_ParseExpr(Parse);
+        ExprRef Condition = Parser_ParseExpr(Parse);
         Parser_ExpectTok(Parse, TOK_CPAREN);
 
-        StmtNode *WhileNode = malloc(sizeof(StmtNode));
-        memset(WhileNode, 0, sizeof(StmtNode));
-        WhileNode->Type = STMT_WHILE;
-        WhileNode->As.While.Condition = Condition;
-        WhileNode->As.While.Body = NULL;
+        StmtRef WhileNode = AstPool_NewStmt(Parse->Pool, STMT_WHILE);
+        Ast_Stmt(Parse->Pool, WhileNode)->As.While.Condition = Condition;
+
+        StmtList Body = { AST_NULL, AST_NULL };
 
         Parser_ExpectTok(Parse, TOK_OBRACE);
         while (Parser_PeekTok(Parse)->Type != TOK_CBRACE)
         {
-            StmtNode *Stmt = Parser_ParseStmt(Parse);
-            if (WhileNode->As.Func.Body == NULL)
-            {
-                WhileNode->As.Func.Body = Stmt;
-            }
-            else
-            {
-                StmtNode_Append(WhileNode->As.Func.Body, Stmt);
-            }
+            StmtRef Stmt = Parser_ParseStmt(Parse);
+            StmtList_Append(Parse->Pool, &Body, Stmt);
         }
 
         Parser_ConsumeTok(Parse);
 
+        Ast_Stmt(Parse->Pool, WhileNode)->As.While.Body = Body.Head;
         return WhileNode;
     }
     break;
 
     default:
-        StmtNode *Stmt = malloc(sizeof(StmtNode));
-        memset(Stmt, 0, sizeof(StmtNode));
-        Stmt->Type = STMT_EXPR;
-        Stmt->Next = NULL;
-        Stmt->As.Expr = Parser_ParseExpr(Parse);
+        ExprRef Expr = Parser_ParseExpr(Parse);
         Parser_ExpectTok(Parse, TOK_SEMICOLON);
 
+        StmtRef Stmt = AstPool_NewStmt(Parse->Pool, STMT_EXPR);
+        Ast_Stmt(Parse->Pool, Stmt)->As.Expr = Expr;
+
         return Stmt;
     }
 }
 
-StmtNode *Parser_ParseFuncStmt(Parser *Parse, TypeDesc *ReturnType)
+StmtRef Parser_ParseFuncStmt(Parser *Parse, TypeDesc *ReturnType)
 {
-    const char *Name = Parser_ExpectTok(Parse, TOK_IDENT)->String;
+    InternId Name = Parser_ExpectTok(Parse, TOK_IDENT)->Id;
     
-    StmtNode *FuncNode = malloc(sizeof(StmtNode));
-    memset(FuncNode, 0, sizeof(StmtNode));
-    FuncNode->Type = STMT_FUNC;
-    FuncNode->As.Func.Name = strdup(Name);
-    FuncNode->As.Func.Body = NULL;
+    StmtRef FuncNode = AstPool_NewStmt(Parse->Pool, STMT_FUNC);
+    Ast_Stmt(Parse->Pool, FuncNode)->As.Func.Name = Name;
     if (ReturnType)
     {
-        FuncNode->As.Func.ReturnType = *ReturnType;
+        Ast_Stmt(Parse->Pool, FuncNode)->As.Func.ReturnType = *ReturnType;
     }
 
     Parser_ExpectTok(Parse, TOK_OPAREN);
 
-    memset(&FuncNode->As.Func.Params, 0, sizeof(FuncNode->As.Func.Params));
-    for (size_t i = 0; (Parser_PeekTok(Parse)->Type != TOK_CPAREN); i++)
+    // params cant nest so they go straight into the pool as one range
+    AstPool *Pool = Parse->Pool;
+    uint32_t FirstParam = Pool->ParamCount;
+    while (Parser_PeekTok(Parse)->Type != TOK_CPAREN)
     {
         TypeDesc ParamType = Parser_ParseType(Parse);
-        FuncNode->As.Func.Params[i].Type = ParamType;
 
         if (ParamType.Type == TYPE_NOT_A_TYPE)
         {
             printf("parameters must have a type\n");
         }
 
-        const char *ParamName = Parser_ExpectTok(Parse, TOK_IDENT)->String;
-        FuncNode->As.Func.Params[i].Name = ParamName;
+        InternId ParamName = Parser_ExpectTok(Parse, TOK_IDENT)->Id;
+
+        Pool->Params = AstPool_Grow(Pool->Params, Pool->ParamCount, 1, &Pool->ParamCapacity, sizeof(ParamDesc));
+        Pool->Params[Pool->ParamCount++] = (ParamDesc) { ParamName, ParamType };
 
         if (Parser_PeekTok(Parse)->Type != TOK_CPAREN)
         {
@@ -518,45 +845,48 @@ StmtNode *Parser_ParseFuncStmt(Parser *Parse, TypeDesc *ReturnType)
         }
     }
 
+    Ast_Stmt(Pool, FuncNode)->As.Func.FirstParam = FirstParam;
+    Ast_Stmt(Pool, FuncNode)->As.Func.ParamCount = Pool->ParamCount - FirstParam;
+
     Parser_ConsumeTok(Parse);
 
     Parser_ExpectTok(Parse, TOK_OBRACE);
+    if (Parse->DeferBodies)
+    {
+        Parser_DeferBody(Parse, FuncNode);
+        return FuncNode;
+    }
+
+    StmtList Body = { AST_NULL, AST_NULL };
     while (Parser_PeekTok(Parse)->Type != TOK_CBRACE)
     {
-        StmtNode *Stmt = Parser_ParseStmt(Parse);
-        if (FuncNode->As.Func.Body == NULL)
-        {
-            FuncNode->As.Func.Body = Stmt;
-        }
-        else
-        {
-            StmtNode_Append(FuncNode->As.Func.Body, Stmt);
-        }
+        StmtRef Stmt = Parser_ParseStmt(Parse);
+        StmtList_Append(Parse->Pool, &Body, Stmt);
     }
 
     Parser_ConsumeTok(Parse);
 
+    Ast_Stmt(Parse->Pool, FuncNode)->As.Func.Body = Body.Head;
     return FuncNode;
 }
 
-StmtNode *Parser_ParseVarDecl(Parser *Parse, TypeDesc *Type)
+StmtRef Parser_ParseVarDecl(Parser *Parse, TypeDesc *Type)
 {
-    const char *Name = Parser_ExpectTok(Parse, TOK_IDENT)->String;
-
-    StmtNode *VarDecl = malloc(sizeof(StmtNode));
-    memset(VarDecl, 0, sizeof(StmtNode));
-    VarDecl->Type = STMT_VARDECL;
-    VarDecl->As.VarDecl.Type = *Type;
-    VarDecl->As.VarDecl.Name = Name;
-    VarDecl->As.VarDecl.Init = NULL;
+    InternId Name = Parser_ExpectTok(Parse, TOK_IDENT)->Id;
 
+    ExprRef Init = AST_NULL;
     if (Parser_PeekTok(Parse)->Type == TOK_EQUAL)
     {
         Parser_ConsumeTok(Parse);
-        VarDecl->As.VarDecl.Init = Parser_ParseExpr(Parse);
+        Init = Parser_ParseExpr(Parse);
     }
 
     Parser_ExpectTok(Parse, TOK_SEMICOLON);
 
+    StmtRef VarDecl = AstPool_NewStmt(Parse->Pool, STMT_VARDECL);
+    Ast_Stmt(Parse->Pool, VarDecl)->As.VarDecl.Type = *Type;
+    Ast_Stmt(Parse->Pool, VarDecl)->As.VarDecl.Name = Name;
+    Ast_Stmt(Parse->Pool, VarDecl)->As.VarDecl.Init = Init;
+
     return VarDecl;
 }
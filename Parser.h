@@ -3,6 +3,7 @@
 #define PARSER_H
 
 #include "Lexer.h"
+#include "SpscRing.h"
 #include <stdbool.h>
 
 typedef enum
@@ -17,7 +18,7 @@ typedef enum
 typedef struct
 {
     TypeType Type;
-    size_t PointerDepth;
+    uint32_t PointerDepth;
 } TypeDesc;
 
 typedef enum
@@ -49,9 +50,13 @@ typedef enum
     OP_LESSTHAN,
 } OpType;
 
-typedef struct Expr_t Expr_t;
+// nodes refer to each other by index into the AstPool arrays, 0 is the null node
+typedef uint32_t ExprRef;
+typedef uint32_t StmtRef;
 
-struct Expr_t
+#define AST_NULL 0
+
+typedef struct
 {
     ExprType Type;
 
@@ -59,95 +64,215 @@ struct Expr_t
     {
         unsigned int NumberLit;
         char CharLit;
-        const char *StringLit;
-        const char *Ident;
+        InternId StringLit;
+        InternId Ident;
         struct 
         {
-            Expr_t *Callee;
-            Expr_t *Arguments[6];
+            ExprRef Callee;
+            uint32_t FirstArg; // range in AstPool::Args
+            uint32_t ArgCount;
         } Call;
         struct
         {
-            Expr_t *Target;
-            Expr_t *Expr;
+            ExprRef Target;
+            ExprRef Expr;
         } Assign;
-        Expr_t *AddressOf;
-        Expr_t *Deref;
-        Expr_t *Inc;
+        ExprRef AddressOf;
+        ExprRef Deref;
+        ExprRef Inc;
         struct
         {
             OpType Op;
-            Expr_t *A;
-            Expr_t *B;
+            ExprRef A;
+            ExprRef B;
         } BinaryOp;
     } As;
-};
+} Expr_t;
 
-typedef struct StmtNode StmtNode;
+typedef struct
+{
+    InternId Name;
+    TypeDesc Type;
+} ParamDesc;
 
-struct StmtNode
+typedef struct
 {
     StmtType Type;
 
     union
     {
-        Expr_t *Expr;
+        ExprRef Expr;
         
         struct
         {
-            char *Name;
-            StmtNode *Body;
-
-            struct
-            {
-                const char *Name;
-                TypeDesc Type;
-            } Params[6];
-
+            InternId Name;
+            StmtRef Body;
+            uint32_t FirstParam; // range in AstPool::Params
+            uint32_t ParamCount;
             TypeDesc ReturnType;
         } Func;
 
-        Expr_t *Return;
+        ExprRef Return;
 
         struct
         {
-            const char *Name;
+            InternId Name;
             TypeDesc Type;
-            Expr_t *Init;
+            ExprRef Init;
+            uint32_t Register; // filled in by RegAlloc, 0 means it lives on the stack
         } VarDecl;
 
         struct
         {
-            Expr_t *Condition;
-            StmtNode *Body;
+            ExprRef Condition;
+            StmtRef Body;
         } While;
     } As;
 
-    StmtNode *Next;
-};
+    StmtRef Next;
+} StmtNode;
 
+// flat storage for a whole ast, freed in one go with AstPool_Free
 typedef struct
 {
-    TokNode *Tok; // current token
-    StmtNode *Ast;
-} Parser;
+    Expr_t *Exprs;
+    uint32_t ExprCount;
+    uint32_t ExprCapacity;
+
+    StmtNode *Stmts;
+    uint32_t StmtCount;
+    uint32_t StmtCapacity;
+
+    ExprRef *Args; // call arguments, each call owns a contiguous range
+    uint32_t ArgCount;
+    uint32_t ArgCapacity;
+
+    ParamDesc *Params; // function parameters, same idea
+    uint32_t ParamCount;
+    uint32_t ParamCapacity;
+} AstPool;
+
+// pointers into the pool are invalidated by the next allocation, hold on to refs instead
+static inline Expr_t *Ast_Expr(AstPool *Pool, ExprRef Ref)
+{
+    return &Pool->Exprs[Ref];
+}
+
+static inline StmtNode *Ast_Stmt(AstPool *Pool, StmtRef Ref)
+{
+    return &Pool->Stmts[Ref];
+}
+
+static inline ExprRef Ast_Arg(AstPool *Pool, Expr_t *Call, uint32_t Index)
+{
+    return Pool->Args[Call->As.Call.FirstArg + Index];
+}
+
+static inline ParamDesc *Ast_Param(AstPool *Pool, StmtNode *Func, uint32_t Index)
+{
+    return &Pool->Params[Func->As.Func.FirstParam + Index];
+}
+
+// statements are chained through StmtNode::Next, the tail is kept so appending is O(1)
+typedef struct
+{
+    StmtRef Head;
+    StmtRef Tail;
+} StmtList;
+
+void StmtList_Append(AstPool *Pool, StmtList *List, StmtRef NewNode);
 
-void StmtNode_FreeAllRecursive(StmtNode *List);
+// pool sizes at some point, everything allocated after it lies between the mark and the counts
+typedef struct
+{
+    uint32_t Expr;
+    uint32_t Stmt;
+    uint32_t Arg;
+    uint32_t Param;
+} AstMark;
+
+ExprRef AstPool_NewExpr(AstPool *Pool, ExprType Type);
+
+StmtRef AstPool_NewStmt(AstPool *Pool, StmtType Type);
+
+// drops every node but keeps the arrays around for the next batch
+void AstPool_Reset(AstPool *Pool);
+
+void AstPool_Free(AstPool *Pool);
+
+#define PARSER_LOOKAHEAD 4
+#define PARSER_BATCH_TOKENS (64 * 1024) // function body tokens per Parser_ParseBatch
+
+// a function body that was brace matched by the top level parse and gets parsed later on a worker
+typedef struct
+{
+    StmtRef Func;
+    uint32_t FirstTok; // range in Parser::BodyToks, the braces themselves arent in it
+    uint32_t TokCount;
+
+    // filled in by the worker, the body nodes live in [From, To) of that worker's pool
+    uint32_t Worker;
+    AstMark From;
+    AstMark To;
+    StmtRef Body;
+} BodyJob;
+
+// where the parser gets its tokens, straight from the lexer unless one of these is set
+typedef struct
+{
+    SpscRing *Ring; // TokenBatch slots filled by a lexer thread
+    TokenBatch *Batch; // slot being read
+    uint32_t BatchPos;
+
+    const Token *Replay; // saved tokens of a deferred body
+    size_t ReplayCount;
+    size_t ReplayPos;
+} TokSource;
+
+typedef struct
+{
+    Lexer *Lex;
+    TokSource Source;
+    StmtList Ast; // top level statements
+    AstPool *Pool;
+
+    // call arguments are collected here first since nested calls would interleave them in AstPool::Args
+    ExprRef *ArgStack;
+    uint32_t ArgStackCount;
+    uint32_t ArgStackCapacity;
+
+    // tokens are pulled from the lexer as the parser asks for them,
+    // only this small lookahead ring is ever kept around
+    Token Ahead[PARSER_LOOKAHEAD];
+    size_t AheadStart;
+    size_t AheadCount;
+    Token Current; // last consumed token
+
+    // top level only, function bodies are skipped and queued here, see Parser_ParseBodies
+    bool DeferBodies;
+    BodyJob *Jobs;
+    uint32_t JobCount;
+    uint32_t JobCapacity;
+    TokArray BodyToks;
+} Parser;
 
-void Expr_FreeRecursive(Expr_t *Expr);
+// parses a few top level declarations at a time, function bodies are skipped and parsed in parallel
+// once about PARSER_BATCH_TOKENS of them are queued. returns the first statement of the batch or
+// AST_NULL at the end of the input
+StmtRef Parser_ParseBatch(Parser *Parse);
 
-void Parser_Parse(Parser *Parse);
+void Parser_Free(Parser *Parse);
 
-StmtNode *Parser_ParseStmt(Parser *Parse);
+StmtRef Parser_ParseStmt(Parser *Parse);
 
-StmtNode *Parser_ParseFuncStmt(Parser *Parse, TypeDesc *ReturnType);
+StmtRef Parser_ParseFuncStmt(Parser *Parse, TypeDesc *ReturnType);
 
-StmtNode *Parser_ParseVarDecl(Parser *Parse, TypeDesc *Type);
+StmtRef Parser_ParseVarDecl(Parser *Parse, TypeDesc *Type);
 
-Expr_t *Parser_ParseExpr(Parser *Parse);
+ExprRef Parser_ParseExpr(Parser *Parse);
 
-Expr_t *Parser_ParsePrimary(Parser *Parse);
+ExprRef Parser_ParsePrimary(Parser *Parse);
 
-Expr_t *Parser_ParseSecondary(Parser *Parse);
+ExprRef Parser_ParseSecondary(Parser *Parse);
 
 #endif // PARSER_H
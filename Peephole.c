@@ -0,0 +1,383 @@
+#include <stdlib.h>
+#include <string.h>
+#include "Peephole.h"
+
+#define PEEPHOLE_MAX_OPERANDS 4
+
+// operand sizes in bytes per opcode, 0 ends the list. opcodes missing here arent Known, the pass
+// gives up on them instead of guessing how long they are
+typedef struct
+{
+    bool Known;
+    uint8_t Operands[PEEPHOLE_MAX_OPERANDS];
+} OpInfo;
+
+#define PEEPHOLE_OP(...) { true, { __VA_ARGS__ } }
+
+static const OpInfo Peephole_Ops[END_INSTRUCTIONS + 1] =
+{
+    [NOP] = PEEPHOLE_OP(0),
+    [LOAD_QWORD] = PEEPHOLE_OP(8, 8),
+    [LOAD_BYTE] = PEEPHOLE_OP(8, 1),
+    [PUSH_QWORD] = PEEPHOLE_OP(8),
+    [POP_QWORD] = PEEPHOLE_OP(8),
+    [CALL] = PEEPHOLE_OP(8),
+    [RETURN] = PEEPHOLE_OP(0),
+    [JUMP] = PEEPHOLE_OP(8),
+    [JUMP_IF_ZERO] = PEEPHOLE_OP(8),
+    [JUMP_IF_EQUAL] = PEEPHOLE_OP(8),
+    [TICK_FLAGS] = PEEPHOLE_OP(0),
+    [SET_FLAGS_BYTE] = PEEPHOLE_OP(8),
+    [COMPARE_QWORD] = PEEPHOLE_OP(8, 8),
+    [COMPARE_BYTE] = PEEPHOLE_OP(1, 1),
+    [MAP_GREATER_BYTE] = PEEPHOLE_OP(8),
+    [STACK_READ_QWORD] = PEEPHOLE_OP(8, 8),
+    [STACK_WRITE_QWORD] = PEEPHOLE_OP(8, 8),
+    [STACK_POINTER_FROM_OFFSET] = PEEPHOLE_OP(8, 8),
+    [MOVE_QWORD] = PEEPHOLE_OP(8, 8),
+    [MOVE_DYNAMIC] = PEEPHOLE_OP(8, 1, 8, 1),
+    [SYSCALL] = PEEPHOLE_OP(1, 8),
+    [INC_QWORD] = PEEPHOLE_OP(8),
+    [ADD_QWORD] = PEEPHOLE_OP(8, 8, 8),
+    [SUB_QWORD] = PEEPHOLE_OP(8, 8, 8),
+    [DEREF_QWORD] = PEEPHOLE_OP(8, 8),
+    [DEREF_BYTE] = PEEPHOLE_OP(8, 8),
+    [DUMP_STATE] = PEEPHOLE_OP(0),
+    [END_INSTRUCTIONS] = PEEPHOLE_OP(0),
+};
+
+typedef struct
+{
+    QWord Pos; // where it was emitted
+    QWord NewPos;
+    Byte Op;
+    QWord Operands[PEEPHOLE_MAX_OPERANDS];
+    bool Dead;
+    bool Target; // something jumps or calls here, cant be merged into the one before it
+    bool Pinned; // something patches its operands at runtime, leave it exactly as it is
+} Instr;
+
+static uint32_t Peephole_Length(Byte Op)
+{
+    uint32_t Length = 1;
+    for (uint32_t i = 0; i < PEEPHOLE_MAX_OPERANDS && Peephole_Ops[Op].Operands[i]; i++)
+    {
+        Length += Peephole_Ops[Op].Operands[i];
+    }
+    return Length;
+}
+
+// index of the instruction containing Addr, Count if its past the end
+static size_t Peephole_Find(Instr *Instrs, size_t Count, QWord Addr)
+{
+    size_t Low = 0;
+    size_t High = Count;
+    while (Low < High)
+    {
+        size_t Mid = (Low + High) / 2;
+        if (Instrs[Mid].Pos <= Addr)
+        {
+            Low = Mid + 1;
+        }
+        else
+        {
+            High = Mid;
+        }
+    }
+    return Low - 1;
+}
+
+static size_t Peephole_NextLive(Instr *Instrs, size_t Count, size_t i)
+{
+    for (i++; i < Count && Instrs[i].Dead; i++)
+    {
+    }
+    return i;
+}
+
+static inline void Peephole_Kill(Instr *In, PeepholeStats *Stats)
+{
+    In->Dead = true;
+    Stats->RemovedInstructions++;
+    Stats->RemovedBytes += Peephole_Length(In->Op);
+}
+
+// turns In into MOVE_QWORD From, To
+static inline void Peephole_MakeMove(Instr *In, QWord From, QWord To, PeepholeStats *Stats)
+{
+    Stats->RemovedBytes += Peephole_Length(In->Op);
+    Stats->RemovedBytes -= Peephole_Length(MOVE_QWORD);
+    In->Op = MOVE_QWORD;
+    In->Operands[0] = From;
+    In->Operands[1] = To;
+}
+
+// looks at the pair starting at i, returns true if anything changed
+static bool Peephole_Pair(Instr *Instrs, size_t Count, size_t i, PeepholeStats *Stats)
+{
+    Instr *A = &Instrs[i];
+
+    // a move to itself does nothing on its own, unless its operands get patched at runtime
+    if (!A->Pinned && (A->Op == NOP || (A->Op == MOVE_QWORD && A->Operands[0] == A->Operands[1])))
+    {
+        Peephole_Kill(A, Stats);
+        return true;
+    }
+
+    size_t Next = Peephole_NextLive(Instrs, Count, i);
+    if (Next == Count)
+    {
+        return false;
+    }
+
+    Instr *B = &Instrs[Next];
+
+    // jumping over nothing but dead code lands on the next instruction anyway
+    if (A->Op == JUMP && !A->Pinned && A->Operands[0] > A->Pos)
+    {
+        size_t To = Peephole_Find(Instrs, Count, A->Operands[0]);
+        if (Instrs[To].Pos == A->Operands[0] && To <= Next)
+        {
+            Peephole_Kill(A, Stats);
+            return true;
+        }
+    }
+
+    if (B->Target || B->Pinned)
+    {
+        return false;
+    }
+
+    // nothing jumps here and control doesnt fall through, e.g. the implicit epilogue after a return
+    if ((A->Op == RETURN || A->Op == JUMP) && B->Op != END_INSTRUCTIONS)
+    {
+        Peephole_Kill(B, Stats);
+        return true;
+    }
+
+    if (A->Pinned)
+    {
+        return false;
+    }
+
+    if (A->Op == PUSH_QWORD && B->Op == POP_QWORD)
+    {
+        // popping into 0 is how codegen throws a value away
+        if (A->Operands[0] == B->Operands[0] || B->Operands[0] == 0)
+        {
+            Peephole_Kill(A, Stats);
+            Peephole_Kill(B, Stats);
+        }
+        else
+        {
+            Peephole_MakeMove(A, A->Operands[0], B->Operands[0], Stats);
+            Peephole_Kill(B, Stats);
+        }
+        return true;
+    }
+
+    if (A->Op == MOVE_QWORD && B->Op == MOVE_QWORD)
+    {
+        // the second one is either the same move again or moves the value straight back
+        if ((A->Operands[0] == B->Operands[0] && A->Operands[1] == B->Operands[1])
+            || (A->Operands[0] == B->Operands[1] && A->Operands[1] == B->Operands[0]))
+        {
+            Peephole_Kill(B, Stats);
+            return true;
+        }
+    }
+
+    // store then reload of the same slot, nothing can move the stack pointer in between
+    if (A->Op == STACK_WRITE_QWORD && B->Op == STACK_READ_QWORD && A->Operands[0] == B->Operands[0])
+    {
+        if (A->Operands[1] == B->Operands[1])
+        {
+            Peephole_Kill(B, Stats);
+        }
+        else
+        {
+            Peephole_MakeMove(B, A->Operands[1], B->Operands[1], Stats);
+        }
+        return true;
+    }
+
+    return false;
+}
+
+static QWord Peephole_Retarget(Instr *Instrs, size_t Count, QWord Start, QWord End, QWord NewEnd, QWord Addr)
+{
+    if (Addr < Start || Addr > End)
+    {
+        return Addr;
+    }
+    if (Addr == End)
+    {
+        return NewEnd;
+    }
+
+    // dead instructions have the NewPos of whatever comes after them, which is where a jump there should land
+    Instr *In = &Instrs[Peephole_Find(Instrs, Count, Addr)];
+    return In->NewPos + (Addr - In->Pos);
+}
+
+bool Peephole_Run(CodeBuffer *Code, QWord Start, QWord *Relocs, size_t RelocCount, QWord *Moves, size_t MoveCount, PeepholeStats *Stats)
+{
+    Stats->RemovedInstructions = 0;
+    Stats->RemovedBytes = 0;
+
+    QWord End = Code->Position;
+
+    // decode
+    size_t Count = 0;
+    size_t Capacity = 1024;
+    Instr *Instrs = malloc(Capacity * sizeof(Instr));
+
+    for (QWord Pos = Start; Pos < End;)
+    {
+        Byte Op = Code->Data[Pos];
+        if (Op > END_INSTRUCTIONS || !Peephole_Ops[Op].Known || Pos + Peephole_Length(Op) > End)
+        {
+            free(Instrs);
+            return false;
+        }
+
+        if (Count == Capacity)
+        {
+            Capacity *= 2;
+            Instrs = realloc(Instrs, Capacity * sizeof(Instr));
+        }
+
+        Instr *In = &Instrs[Count++];
+        memset(In, 0, sizeof(Instr));
+        In->Pos = Pos;
+        In->Op = Op;
+
+        QWord OperandPos = Pos + 1;
+        for (uint32_t i = 0; i < PEEPHOLE_MAX_OPERANDS && Peephole_Ops[Op].Operands[i]; i++)
+        {
+            In->Operands[i] = (Peephole_Ops[Op].Operands[i] == 8) ? CodeBuf_ReadQWord(Code, OperandPos) : Code->Data[OperandPos];
+            OperandPos += Peephole_Ops[Op].Operands[i];
+        }
+        Pos = OperandPos;
+    }
+
+    // anything a code address points at has to stay where it is relative to its neighbours
+    for (size_t i = 0; i < RelocCount; i++)
+    {
+        QWord Addr = CodeBuf_ReadQWord(Code, Relocs[i]);
+        if (Addr < Start || Addr >= End)
+        {
+            continue;
+        }
+
+        Instr *In = &Instrs[Peephole_Find(Instrs, Count, Addr)];
+        if (In->Pos == Addr)
+        {
+            In->Target = true;
+        }
+        else
+        {
+            In->Pinned = true;
+        }
+    }
+
+    // keep going until nothing matches, one removal can line up the next pair
+    bool Changed = true;
+    while (Changed)
+    {
+        Changed = false;
+        for (size_t i = 0; i < Count; i++)
+        {
+            if (!Instrs[i].Dead && Peephole_Pair(Instrs, Count, i, Stats))
+            {
+                Changed = true;
+            }
+        }
+    }
+
+    if (Stats->RemovedInstructions == 0)
+    {
+        free(Instrs);
+        return true;
+    }
+
+    QWord NewEnd = Start;
+    for (size_t i = 0; i < Count; i++)
+    {
+        Instrs[i].NewPos = NewEnd;
+        if (!Instrs[i].Dead)
+        {
+            NewEnd += Peephole_Length(Instrs[i].Op);
+        }
+    }
+
+    // operands are code addresses by position, so retarget them before anything moves
+    for (size_t i = 0; i < RelocCount; i++)
+    {
+        QWord Addr = CodeBuf_ReadQWord(Code, Relocs[i]);
+        QWord NewAddr = Peephole_Retarget(Instrs, Count, Start, End, NewEnd, Addr);
+
+        if (Relocs[i] >= Start && Relocs[i] < End)
+        {
+            Instr *In = &Instrs[Peephole_Find(Instrs, Count, Relocs[i])];
+            if (In->Dead)
+            {
+                continue;
+            }
+
+            // find which operand it is
+            QWord OperandPos = In->Pos + 1;
+            for (uint32_t j = 0; j < PEEPHOLE_MAX_OPERANDS && Peephole_Ops[In->Op].Operands[j]; j++)
+            {
+                if (OperandPos == Relocs[i])
+                {
+                    In->Operands[j] = NewAddr;
+                }
+                OperandPos += Peephole_Ops[In->Op].Operands[j];
+            }
+            Relocs[i] = In->NewPos + (Relocs[i] - In->Pos);
+        }
+        else
+        {
+            CodeBuf_WriteQWord(Code, Relocs[i], NewAddr);
+        }
+    }
+
+    // encode, never overtakes the reads since it only ever moves down
+    for (size_t i = 0; i < Count; i++)
+    {
+        Instr *In = &Instrs[i];
+        if (In->Dead)
+        {
+            continue;
+        }
+
+        QWord Pos = In->NewPos;
+        Code->Data[Pos++] = In->Op;
+        for (uint32_t j = 0; j < PEEPHOLE_MAX_OPERANDS && Peephole_Ops[In->Op].Operands[j]; j++)
+        {
+            if (Peephole_Ops[In->Op].Operands[j] == 8)
+            {
+                CodeBuf_WriteQWord(Code, Pos, In->Operands[j]);
+                Pos += 8;
+            }
+            else
+            {
+                Code->Data[Pos++] = (Byte)In->Operands[j];
+            }
+        }
+    }
+
+    for (size_t i = 0; i < MoveCount; i++)
+    {
+        if (Moves[i] >= Start && Moves[i] < End)
+        {
+            Instr *In = &Instrs[Peephole_Find(Instrs, Count, Moves[i])];
+            Moves[i] = In->Dead ? PEEPHOLE_DEAD_MOVE : In->NewPos + (Moves[i] - In->Pos);
+        }
+    }
+
+    Code->Position = NewEnd;
+    free(Instrs);
+    return true;
+}
@@ -0,0 +1,25 @@
+#ifndef PEEPHOLE_H
+#define PEEPHOLE_H
+
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "CodeBuffer.h"
+
+#define PEEPHOLE_DEAD_MOVE ((QWord)-1)
+
+typedef struct
+{
+    size_t RemovedInstructions;
+    size_t RemovedBytes;
+} PeepholeStats;
+
+// rewrites the finished code from Start to Code->Position in place and shrinks it to match.
+// Relocs are the positions of every operand holding a code address (jump targets, call labels,
+// function pointers, self patching moves), they get moved and retargeted along with the code.
+// Moves are other operand positions that only have to follow the code around,
+// the ones inside removed instructions become PEEPHOLE_DEAD_MOVE.
+// leaves everything alone and returns false if the code cant be decoded or uses an opcode it doesnt know
+bool Peephole_Run(CodeBuffer *Code, QWord Start, QWord *Relocs, size_t RelocCount, QWord *Moves, size_t MoveCount, PeepholeStats *Stats);
+
+#endif // PEEPHOLE_H
@@ -0,0 +1,145 @@
+#include <pthread.h>
+#include <stdlib.h>
+#include "Pipeline.h"
+
+#define PIPELINE_TOKEN_SLOTS 16
+#define PIPELINE_DECL_SLOTS 4
+
+typedef struct
+{
+    AstPool Pool; // reused by every batch that goes through this slot
+    StmtRef Head; // AST_NULL once the input is done
+} DeclBatch;
+
+typedef struct
+{
+    Parser *Parse;
+    SpscRing Tokens; // lexer thread -> parser thread
+    SpscRing Decls; // parser thread -> codegen
+} Pipeline;
+
+// a batch of top level declarations at a time, its ast is dropped as soon as its code is out
+// so the pool only ever grows to the biggest batch instead of the whole file
+static void Pipeline_Sequential(Parser *Parse, Compiler *Cmpl)
+{
+    StmtRef Decl;
+    while ((Decl = Parser_ParseBatch(Parse)) != AST_NULL)
+    {
+        for (; Decl; Decl = Ast_Stmt(Parse->Pool, Decl)->Next)
+        {
+            Compiler_GenStmt(Cmpl, Decl);
+        }
+        AstPool_Reset(Parse->Pool);
+    }
+}
+
+static void *Pipeline_LexerThread(void *Arg)
+{
+    Pipeline *Pipe = Arg;
+
+    uint32_t Count;
+    do
+    {
+        TokenBatch *Batch = SpscRing_PushSlot(&Pipe->Tokens);
+        Count = Lexer_FillBatch(Pipe->Parse->Lex, Batch);
+        SpscRing_Push(&Pipe->Tokens);
+    } while (Count != 0);
+
+    return NULL;
+}
+
+static void *Pipeline_ParserThread(void *Arg)
+{
+    Pipeline *Pipe = Arg;
+    Parser *Parse = Pipe->Parse;
+
+    StmtRef Head;
+    do
+    {
+        DeclBatch *Batch = SpscRing_PushSlot(&Pipe->Decls);
+        AstPool_Reset(&Batch->Pool);
+        Parse->Pool = &Batch->Pool;
+        Head = Batch->Head = Parser_ParseBatch(Parse);
+        SpscRing_Push(&Pipe->Decls);
+    } while (Head != AST_NULL);
+
+    return NULL;
+}
+
+static bool Pipeline_Wanted(Parser *Parse)
+{
+    // FCC_PIPELINE=0/1 overrides the size check
+    const char *Env = getenv("FCC_PIPELINE");
+    if (Env)
+    {
+        return atoi(Env) != 0;
+    }
+    return Parse->Lex->Length - Parse->Lex->Pos >= PIPELINE_MIN_BYTES;
+}
+
+void Pipeline_Compile(Parser *Parse, Compiler *Cmpl)
+{
+    if (!Pipeline_Wanted(Parse))
+    {
+        Pipeline_Sequential(Parse, Cmpl);
+        return;
+    }
+
+    // the lexer thread is the only one interning from here on, interned views never move
+    // so codegen can still read them
+    Pipeline Pipe = { .Parse = Parse };
+    SpscRing_Init(&Pipe.Tokens, sizeof(TokenBatch), PIPELINE_TOKEN_SLOTS);
+    SpscRing_Init(&Pipe.Decls, sizeof(DeclBatch), PIPELINE_DECL_SLOTS);
+
+    pthread_t LexerThread;
+    if (pthread_create(&LexerThread, NULL, Pipeline_LexerThread, &Pipe) != 0)
+    {
+        SpscRing_Free(&Pipe.Tokens);
+        SpscRing_Free(&Pipe.Decls);
+        Pipeline_Sequential(Parse, Cmpl);
+        return;
+    }
+
+    AstPool *OwnPool = Parse->Pool;
+    Parse->Source.Ring = &Pipe.Tokens;
+
+    pthread_t ParserThread;
+    if (pthread_create(&ParserThread, NULL, Pipeline_ParserThread, &Pipe) != 0)
+    {
+        // still reads the lexer thread's tokens, just parses on this thread
+        Pipeline_Sequential(Parse, Cmpl);
+    }
+    else
+    {
+        while (true)
+        {
+            DeclBatch *Batch = SpscRing_PopSlot(&Pipe.Decls);
+            if (Batch->Head == AST_NULL)
+            {
+                break;
+            }
+
+            Cmpl->Pool = &Batch->Pool;
+            for (StmtRef Decl = Batch->Head; Decl; Decl = Ast_Stmt(&Batch->Pool, Decl)->Next)
+            {
+                Compiler_GenStmt(Cmpl, Decl);
+            }
+            SpscRing_Pop(&Pipe.Decls);
+        }
+
+        pthread_join(ParserThread, NULL);
+    }
+
+    pthread_join(LexerThread, NULL);
+
+    for (size_t i = 0; i < PIPELINE_DECL_SLOTS; i++)
+    {
+        AstPool_Free(&((DeclBatch *)SpscRing_Slot(&Pipe.Decls, i))->Pool);
+    }
+    SpscRing_Free(&Pipe.Tokens);
+    SpscRing_Free(&Pipe.Decls);
+
+    Parse->Source = (TokSource) {0};
+    Parse->Pool = OwnPool;
+    Cmpl->Pool = OwnPool;
+}
@@ -0,0 +1,14 @@
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include "Parser.h"
+#include "Compiler.h"
+
+#define PIPELINE_MIN_BYTES (1024 * 1024) // smaller inputs are done before the threads would pay off
+
+// parses and compiles everything the parser's lexer has left, Cmpl must already be begun.
+// big inputs get the lexer and the parser on their own threads feeding codegen on this one,
+// the output is the same either way
+void Pipeline_Compile(Parser *Parse, Compiler *Cmpl);
+
+#endif // PIPELINE_H
@@ -0,0 +1,268 @@
+#include <stdlib.h>
+#include <stdbool.h>
+#include "RegAlloc.h"
+
+const QWord RegAlloc_Registers[REGALLOC_COUNT] = { REGISTER64_C, REGISTER64_D };
+
+typedef struct
+{
+    StmtRef Decl; // AST_NULL for params, they stay on the stack
+    InternId Name;
+    uint32_t Start; // position of the declaration
+    uint32_t End; // last use
+    bool AddressTaken;
+    int Register; // index into RegAlloc_Registers, -1 for the stack
+} LiveRange;
+
+typedef struct
+{
+    AstPool *Pool;
+    uint32_t Pos; // bumped for every expression and declaration, in codegen order
+
+    LiveRange *Ranges;
+    uint32_t RangeCount;
+    uint32_t RangeCapacity;
+
+    uint32_t *Scope; // indices into Ranges currently visible, innermost last
+    uint32_t ScopeCount;
+    uint32_t ScopeCapacity;
+} RegAllocState;
+
+static void RegAlloc_Declare(RegAllocState *State, InternId Name, StmtRef Decl)
+{
+    if (State->RangeCount == State->RangeCapacity)
+    {
+        State->RangeCapacity = (State->RangeCapacity == 0) ? 32 : (State->RangeCapacity * 2);
+        State->Ranges = realloc(State->Ranges, State->RangeCapacity * sizeof(LiveRange));
+    }
+    if (State->ScopeCount == State->ScopeCapacity)
+    {
+        State->ScopeCapacity = (State->ScopeCapacity == 0) ? 32 : (State->ScopeCapacity * 2);
+        State->Scope = realloc(State->Scope, State->ScopeCapacity * sizeof(uint32_t));
+    }
+
+    State->Ranges[State->RangeCount] = (LiveRange) { Decl, Name, State->Pos, State->Pos, Decl == AST_NULL, -1 };
+    State->Scope[State->ScopeCount++] = State->RangeCount++;
+}
+
+// NULL for globals and functions, they arent ours to allocate
+static LiveRange *RegAlloc_Lookup(RegAllocState *State, InternId Name)
+{
+    for (uint32_t i = State->ScopeCount; i-- > 0;)
+    {
+        LiveRange *Range = &State->Ranges[State->Scope[i]];
+        if (Range->Name == Name)
+        {
+            return Range;
+        }
+    }
+    return NULL;
+}
+
+static void RegAlloc_WalkExpr(RegAllocState *State, ExprRef Ref)
+{
+    if (Ref == AST_NULL)
+    {
+        return;
+    }
+
+    Expr_t *Expr = Ast_Expr(State->Pool, Ref);
+    switch (Expr->Type)
+    {
+    case EXPR_IDENT:
+    {
+        LiveRange *Range = RegAlloc_Lookup(State, Expr->As.Ident);
+        if (Range)
+        {
+            Range->End = State->Pos;
+        }
+    }
+    break;
+
+    case EXPR_CALL:
+        for (uint32_t i = Expr->As.Call.ArgCount; i-- > 0;)
+        {
+            RegAlloc_WalkExpr(State, Ast_Arg(State->Pool, Expr, i));
+        }
+        RegAlloc_WalkExpr(State, Expr->As.Call.Callee);
+        break;
+
+    case EXPR_ASSIGN:
+        RegAlloc_WalkExpr(State, Expr->As.Assign.Expr);
+        RegAlloc_WalkExpr(State, Expr->As.Assign.Target);
+        break;
+
+    case EXPR_ADDRESSOF:
+    {
+        Expr_t *Operand = Ast_Expr(State->Pool, Expr->As.AddressOf);
+        if (Operand->Type == EXPR_IDENT)
+        {
+            LiveRange *Range = RegAlloc_Lookup(State, Operand->As.Ident);
+            if (Range)
+            {
+                Range->AddressTaken = true;
+            }
+        }
+        RegAlloc_WalkExpr(State, Expr->As.AddressOf);
+    }
+    break;
+
+    case EXPR_DEREF:
+        RegAlloc_WalkExpr(State, Expr->As.Deref);
+        break;
+
+    case EXPR_INC:
+        RegAlloc_WalkExpr(State, Expr->As.Inc);
+        break;
+
+    case EXPR_BINARYOP:
+        RegAlloc_WalkExpr(State, Expr->As.BinaryOp.A);
+        RegAlloc_WalkExpr(State, Expr->As.BinaryOp.B);
+        break;
+
+    default:
+        break;
+    }
+
+    State->Pos++;
+}
+
+static void RegAlloc_WalkBody(RegAllocState *State, StmtRef Node);
+
+static void RegAlloc_WalkStmt(RegAllocState *State, StmtRef Ref)
+{
+    StmtNode *Stmt = Ast_Stmt(State->Pool, Ref);
+    switch (Stmt->Type)
+    {
+    case STMT_EXPR:
+        RegAlloc_WalkExpr(State, Stmt->As.Expr);
+        break;
+
+    case STMT_RETURN:
+        RegAlloc_WalkExpr(State, Stmt->As.Return);
+        break;
+
+    case STMT_VARDECL:
+        RegAlloc_WalkExpr(State, Stmt->As.VarDecl.Init);
+        RegAlloc_Declare(State, Stmt->As.VarDecl.Name, Ref);
+        State->Pos++;
+        break;
+
+    case STMT_WHILE:
+    {
+        uint32_t LoopStart = State->Pos;
+        RegAlloc_WalkExpr(State, Stmt->As.While.Condition);
+        RegAlloc_WalkBody(State, Stmt->As.While.Body);
+        uint32_t LoopEnd = State->Pos++;
+
+        // the back edge reads them again, so anything from before the loop thats used in it lives through all of it
+        for (uint32_t i = 0; i < State->RangeCount; i++)
+        {
+            LiveRange *Range = &State->Ranges[i];
+            if (Range->Start < LoopStart && Range->End >= LoopStart)
+            {
+                Range->End = LoopEnd;
+            }
+        }
+    }
+    break;
+
+    default:
+        break; // nested functions get their own pass when codegen reaches them
+    }
+}
+
+static void RegAlloc_WalkBody(RegAllocState *State, StmtRef Node)
+{
+    uint32_t ScopeMark = State->ScopeCount;
+    for (; Node; Node = Ast_Stmt(State->Pool, Node)->Next)
+    {
+        RegAlloc_WalkStmt(State, Node);
+    }
+    State->ScopeCount = ScopeMark;
+}
+
+uint32_t RegAlloc_Function(AstPool *Pool, StmtRef Func)
+{
+    RegAllocState State = { Pool, 0, NULL, 0, 0, NULL, 0, 0 };
+
+    StmtNode *FuncNode = Ast_Stmt(Pool, Func);
+    for (uint32_t i = 0; i < FuncNode->As.Func.ParamCount; i++)
+    {
+        RegAlloc_Declare(&State, Ast_Param(Pool, FuncNode, i)->Name, AST_NULL);
+    }
+    RegAlloc_WalkBody(&State, FuncNode->As.Func.Body);
+
+    // ranges are already sorted by start since they were made in walk order,
+    // Active holds the ranges in registers sorted by end
+    uint32_t Active[REGALLOC_COUNT];
+    uint32_t ActiveCount = 0;
+    uint32_t UsedMask = 0;
+
+    for (uint32_t i = 0; i < State.RangeCount; i++)
+    {
+        LiveRange *Range = &State.Ranges[i];
+        if (Range->AddressTaken)
+        {
+            continue;
+        }
+
+        // free up whatever ended before this one starts
+        uint32_t Kept = 0;
+        uint32_t FreeMask = (1u << REGALLOC_COUNT) - 1;
+        for (uint32_t j = 0; j < ActiveCount; j++)
+        {
+            if (State.Ranges[Active[j]].End >= Range->Start)
+            {
+                Active[Kept++] = Active[j];
+                FreeMask &= ~(1u << State.Ranges[Active[j]].Register);
+            }
+        }
+        ActiveCount = Kept;
+
+        if (FreeMask)
+        {
+            Range->Register = __builtin_ctz(FreeMask);
+        }
+        else
+        {
+            // all taken, whoever lives longest goes to the stack
+            LiveRange *Last = &State.Ranges[Active[ActiveCount - 1]];
+            if (Last->End <= Range->End)
+            {
+                continue;
+            }
+            Range->Register = Last->Register;
+            Last->Register = -1;
+            ActiveCount--;
+        }
+
+        uint32_t Slot = ActiveCount++;
+        while (Slot > 0 && State.Ranges[Active[Slot - 1]].End > Range->End)
+        {
+            Active[Slot] = Active[Slot - 1];
+            Slot--;
+        }
+        Active[Slot] = i;
+    }
+
+    for (uint32_t i = 0; i < State.RangeCount; i++)
+    {
+        LiveRange *Range = &State.Ranges[i];
+        if (Range->Decl == AST_NULL)
+        {
+            continue;
+        }
+
+        QWord Register = (Range->Register < 0) ? 0 : RegAlloc_Registers[Range->Register];
+        Ast_Stmt(Pool, Range->Decl)->As.VarDecl.Register = (uint32_t)Register;
+        if (Range->Register >= 0)
+        {
+            UsedMask |= 1u << Range->Register;
+        }
+    }
+
+    free(State.Ranges);
+    free(State.Scope);
+    return UsedMask;
+}
@@ -0,0 +1,18 @@
+#ifndef REGALLOC_H
+#define REGALLOC_H
+
+#include "Parser.h"
+
+#include "../furnvm/BytecodeBuilder.h"
+
+// registers locals can live in, A and B stay free as expression temporaries.
+// functions save the ones they use so they survive calls
+#define REGALLOC_COUNT 2
+
+extern const QWord RegAlloc_Registers[REGALLOC_COUNT];
+
+// linear scan over one function body, locals whose address is never taken get a register
+// in their VarDecl.Register while there are any left, returns a mask of the RegAlloc_Registers used
+uint32_t RegAlloc_Function(AstPool *Pool, StmtRef Func);
+
+#endif // REGALLOC_H
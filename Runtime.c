@@ -0,0 +1,1196 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "Runtime.h"
+
+#define RUNTIME_HASH_SEED 0xcbf29ce484222325ull
+
+typedef struct
+{
+    uint32_t Magic;
+    uint32_t Version;
+    uint64_t Compiler; // identifies the executable whose emitters built the blob, see Runtime_KeyExe
+    uint64_t Hash; // hash of everything after the header
+    uint32_t FuncCount;
+    uint32_t RelocCount;
+    uint32_t CallCount;
+    uint32_t DataRelocCount;
+    uint32_t CodeSize;
+} RuntimeHeader;
+
+typedef struct
+{
+    uint32_t Position;
+    const char *Callee;
+} PendingCall;
+
+// the blob while its being emitted, everything is at its final address since the blob starts at 0
+typedef struct
+{
+    CodeBuffer Code;
+
+    uint32_t *Relocs;
+    uint32_t RelocCount;
+    uint32_t RelocCapacity;
+
+    PendingCall *Calls;
+    uint32_t CallCount;
+    uint32_t CallCapacity;
+
+    uint32_t *DataRelocs;
+    uint32_t DataRelocCount;
+    uint32_t DataRelocCapacity;
+} RuntimeBuild;
+
+static void Runtime_PutCodeAddress(RuntimeBuild *Build, QWord Address)
+{
+    if (Build->RelocCount == Build->RelocCapacity)
+    {
+        Build->RelocCapacity = (Build->RelocCapacity == 0) ? 64 : (Build->RelocCapacity * 2);
+        Build->Relocs = realloc(Build->Relocs, Build->RelocCapacity * sizeof(uint32_t));
+    }
+
+    Build->Relocs[Build->RelocCount++] = (uint32_t)Build->Code.Position;
+    CodeBuf_PutAddress(&Build->Code, Address);
+}
+
+// calls into another builtin, resolved to an index once they are all emitted
+static void Runtime_PutFuncAddress(RuntimeBuild *Build, const char *Callee)
+{
+    if (Build->CallCount == Build->CallCapacity)
+    {
+        Build->CallCapacity = (Build->CallCapacity == 0) ? 16 : (Build->CallCapacity * 2);
+        Build->Calls = realloc(Build->Calls, Build->CallCapacity * sizeof(PendingCall));
+    }
+
+    Build->Calls[Build->CallCount++] = (PendingCall) { (uint32_t)Build->Code.Position, Callee };
+    CodeBuf_PutAddress(&Build->Code, 0);
+}
+
+// Offset is one of the RUNTIME_OUT_ offsets, the compiler adds where the runtime's data ends up
+static void Runtime_PutDataAddress(RuntimeBuild *Build, QWord Offset)
+{
+    if (Build->DataRelocCount == Build->DataRelocCapacity)
+    {
+        Build->DataRelocCapacity = (Build->DataRelocCapacity == 0) ? 64 : (Build->DataRelocCapacity * 2);
+        Build->DataRelocs = realloc(Build->DataRelocs, Build->DataRelocCapacity * sizeof(uint32_t));
+    }
+
+    Build->DataRelocs[Build->DataRelocCount++] = (uint32_t)Build->Code.Position;
+    CodeBuf_PutAddress(&Build->Code, Offset);
+}
+
+// appends the byte at Char to the output buffer, flushing when its full or on a newline when line buffered.
+// uses B, Char has to be a one byte address since it goes through COMPARE_BYTE
+static void Runtime_EmitAppend(RuntimeBuild *Build, QWord Char)
+{
+    CodeBuf_Put(&Build->Code, LOAD_QWORD);
+    CodeBuf_PutAddress(&Build->Code, REGISTER64_B);
+    Runtime_PutDataAddress(Build, RUNTIME_OUT_BUFFER);
+
+    CodeBuf_Put(&Build->Code, ADD_QWORD);
+    CodeBuf_PutAddress(&Build->Code, REGISTER64_B);
+    CodeBuf_PutAddress(&Build->Code, REGISTER64_B);
+    Runtime_PutDataAddress(Build, RUNTIME_OUT_LENGTH);
+
+    // no store through a pointer, so point the next move's destination at the end of the buffer
+    CodeBuf_Put(&Build->Code, MOVE_QWORD);
+    CodeBuf_PutAddress(&Build->Code, REGISTER64_B);
+    Runtime_PutCodeAddress(Build, Build->Code.Position + 8 + 10);
+
+    CodeBuf_Put(&Build->Code, MOVE_DYNAMIC);
+    CodeBuf_PutAddress(&Build->Code, Char);
+    CodeBuf_Put(&Build->Code, 1);
+    CodeBuf_PutAddress(&Build->Code, 0); // replaced at runtime
+    CodeBuf_Put(&Build->Code, 1);
+
+    CodeBuf_Put(&Build->Code, INC_QWORD);
+    Runtime_PutDataAddress(Build, RUNTIME_OUT_LENGTH);
+
+    CodeBuf_Put(&Build->Code, LOAD_QWORD);
+    CodeBuf_PutAddress(&Build->Code, REGISTER64_B);
+    CodeBuf_PutQWord(&Build->Code, RUNTIME_OUT_CAPACITY);
+
+    CodeBuf_Put(&Build->Code, COMPARE_QWORD);
+    Runtime_PutDataAddress(Build, RUNTIME_OUT_LENGTH);
+    CodeBuf_PutAddress(&Build->Code, REGISTER64_B);
+
+    CodeBuf_Put(&Build->Code, JUMP_IF_EQUAL);
+
+    QWord FullPlaceholder = Build->Code.Position;
+    Runtime_PutCodeAddress(Build, 0); // placeholder
+
+    CodeBuf_Put(&Build->Code, LOAD_BYTE);
+    CodeBuf_PutAddress(&Build->Code, REGISTER_B);
+    CodeBuf_Put(&Build->Code, '\n');
+
+    CodeBuf_Put(&Build->Code, COMPARE_BYTE);
+    CodeBuf_Put(&Build->Code, (Byte)Char);
+    CodeBuf_Put(&Build->Code, REGISTER_B);
+
+    CodeBuf_Put(&Build->Code, TICK_FLAGS); // logical not
+    CodeBuf_Put(&Build->Code, JUMP_IF_EQUAL);
+
+    QWord NewlinePlaceholder = Build->Code.Position;
+    Runtime_PutCodeAddress(Build, 0); // placeholder
+
+    CodeBuf_Put(&Build->Code, SET_FLAGS_BYTE);
+    Runtime_PutDataAddress(Build, RUNTIME_OUT_LINE_BUFFERED);
+
+    CodeBuf_Put(&Build->Code, JUMP_IF_ZERO);
+
+    QWord ModePlaceholder = Build->Code.Position;
+    Runtime_PutCodeAddress(Build, 0); // placeholder
+
+    CodeBuf_WriteQWord(&Build->Code, FullPlaceholder, Build->Code.Position);
+
+    CodeBuf_Put(&Build->Code, CALL);
+    Runtime_PutFuncAddress(Build, "flush");
+
+    CodeBuf_WriteQWord(&Build->Code, NewlinePlaceholder, Build->Code.Position);
+    CodeBuf_WriteQWord(&Build->Code, ModePlaceholder, Build->Code.Position);
+}
+
+// jumps when Left > Right is WhenTrue and returns the placeholder for the target, uses REGISTER_B
+static QWord Runtime_EmitJumpIfGreater(RuntimeBuild *Build, QWord Left, QWord Right, bool WhenTrue)
+{
+    CodeBuf_Put(&Build->Code, COMPARE_QWORD);
+    CodeBuf_PutAddress(&Build->Code, Left);
+    CodeBuf_PutAddress(&Build->Code, Right);
+
+    // theres no jump on greater, the flag goes through a byte
+    CodeBuf_Put(&Build->Code, MAP_GREATER_BYTE);
+    CodeBuf_PutAddress(&Build->Code, REGISTER_B);
+
+    CodeBuf_Put(&Build->Code, SET_FLAGS_BYTE);
+    CodeBuf_PutAddress(&Build->Code, REGISTER_B);
+
+    if (WhenTrue)
+    {
+        CodeBuf_Put(&Build->Code, TICK_FLAGS);
+    }
+
+    CodeBuf_Put(&Build->Code, JUMP_IF_ZERO);
+
+    QWord Placeholder = Build->Code.Position;
+    Runtime_PutCodeAddress(Build, 0); // placeholder
+    return Placeholder;
+}
+
+// leaves D pointing at the largest power in Table thats not above C, or at Table itself.
+// Last is the offset of the largest power, uses B
+static void Runtime_EmitSkipLeading(RuntimeBuild *Build, QWord Table, QWord Last, QWord Step)
+{
+    CodeBuf_Put(&Build->Code, LOAD_QWORD);
+    CodeBuf_PutAddress(&Build->Code, REGISTER64_D);
+    Runtime_PutDataAddress(Build, Table + Last);
+
+    QWord WhileLabel = Build->Code.Position;
+
+    CodeBuf_Put(&Build->Code, LOAD_QWORD);
+    CodeBuf_PutAddress(&Build->Code, REGISTER64_B);
+    Runtime_PutDataAddress(Build, Table);
+
+    CodeBuf_Put(&Build->Code, COMPARE_QWORD);
+    CodeBuf_PutAddress(&Build->Code, REGISTER64_D);
+    CodeBuf_PutAddress(&Build->Code, REGISTER64_B);
+
+    CodeBuf_Put(&Build->Code, JUMP_IF_EQUAL);
+
+    QWord FirstPlaceholder = Build->Code.Position;
+    Runtime_PutCodeAddress(Build, 0); // placeholder
+
+    CodeBuf_Put(&Build->Code, DEREF_QWORD);
+    CodeBuf_PutAddress(&Build->Code, REGISTER64_D);
+    CodeBuf_PutAddress(&Build->Code, REGISTER64_B);
+
+    QWord FitsPlaceholder = Runtime_EmitJumpIfGreater(Build, REGISTER64_B, REGISTER64_C, false);
+
+    CodeBuf_Put(&Build->Code, LOAD_QWORD);
+    CodeBuf_PutAddress(&Build->Code, REGISTER64_B);
+    CodeBuf_PutQWord(&Build->Code, Step);
+
+    CodeBuf_Put(&Build->Code, SUB_QWORD);
+    CodeBuf_PutAddress(&Build->Code, REGISTER64_D);
+    CodeBuf_PutAddress(&Build->Code, REGISTER64_D);
+    CodeBuf_PutAddress(&Build->Code, REGISTER64_B);
+
+    CodeBuf_Put(&Build->Code, JUMP);
+    Runtime_PutCodeAddress(Build, WhileLabel);
+
+    CodeBuf_WriteQWord(&Build->Code, FirstPlaceholder, Build->Code.Position);
+    CodeBuf_WriteQWord(&Build->Code, FitsPlaceholder, Build->Code.Position);
+}
+
+// subtracts the power in ARG2 from C for as long as it fits, adding ARG1 to A each time.
+// theres no divide, but a digit never takes more than 9 (15 for hex) rounds
+static void Runtime_EmitCountDigit(RuntimeBuild *Build)
+{
+    QWord WhileLabel = Build->Code.Position;
+
+    QWord DonePlaceholder = Runtime_EmitJumpIfGreater(Build, SYSCALL_ARG2, REGISTER64_C, true);
+
+    CodeBuf_Put(&Build->Code, SUB_QWORD);
+    CodeBuf_PutAddress(&Build->Code, REGISTER64_C);
+    CodeBuf_PutAddress(&Build->Code, REGISTER64_C);
+    CodeBuf_PutAddress(&Build->Code, SYSCALL_ARG2);
+
+    CodeBuf_Put(&Build->Code, ADD_QWORD);
+    CodeBuf_PutAddress(&Build->Code, REGISTER64_A);
+    CodeBuf_PutAddress(&Build->Code, REGISTER64_A);
+    CodeBuf_PutAddress(&Build->Code, SYSCALL_ARG1);
+
+    CodeBuf_Put(&Build->Code, JUMP);
+    Runtime_PutCodeAddress(Build, WhileLabel);
+
+    CodeBuf_WriteQWord(&Build->Code, DonePlaceholder, Build->Code.Position);
+}
+
+// moves D one power down and jumps back to Label, falls through once D was at Table
+static void Runtime_EmitNextPower(RuntimeBuild *Build, QWord Table, QWord Step, QWord Label)
+{
+    CodeBuf_Put(&Build->Code, LOAD_QWORD);
+    CodeBuf_PutAddress(&Build->Code, REGISTER64_B);
+    Runtime_PutDataAddress(Build, Table);
+
+    CodeBuf_Put(&Build->Code, COMPARE_QWORD);
+    CodeBuf_PutAddress(&Build->Code, REGISTER64_D);
+    CodeBuf_PutAddress(&Build->Code, REGISTER64_B);
+
+    CodeBuf_Put(&Build->Code, JUMP_IF_EQUAL);
+
+    QWord DonePlaceholder = Build->Code.Position;
+    Runtime_PutCodeAddress(Build, 0); // placeholder
+
+    CodeBuf_Put(&Build->Code, LOAD_QWORD);
+    CodeBuf_PutAddress(&Build->Code, REGISTER64_B);
+    CodeBuf_PutQWord(&Build->Code, Step);
+
+    CodeBuf_Put(&Build->Code, SUB_QWORD);
+    CodeBuf_PutAddress(&Build->Code, REGISTER64_D);
+    CodeBuf_PutAddress(&Build->Code, REGISTER64_D);
+    CodeBuf_PutAddress(&Build->Code, REGISTER64_B);
+
+    CodeBuf_Put(&Build->Code, JUMP);
+    Runtime_PutCodeAddress(Build, Label);
+
+    CodeBuf_WriteQWord(&Build->Code, DonePlaceholder, Build->Code.Position);
+}
+
+// write
+static void Runtime_EmitWrite(RuntimeBuild *Build)
+{
+    // goes around the buffer, so whats in it has to go out first
+    CodeBuf_Put(&Build->Code, CALL);
+    Runtime_PutFuncAddress(Build, "flush");
+
+    CodeBuf_Put(&Build->Code, POP_QWORD);
+    CodeBuf_PutAddress(&Build->Code, SYSCALL_ARG1);
+
+    CodeBuf_Put(&Build->Code, POP_QWORD);
+    CodeBuf_PutAddress(&Build->Code, SYSCALL_ARG2);
+
+    CodeBuf_Put(&Build->Code, SYSCALL);
+    CodeBuf_Put(&Build->Code, 1); // write stdout
+    CodeBuf_PutAddress(&Build->Code, REGISTER64_A);
+
+    // arguments already popped off the stack
+    CodeBuf_Put(&Build->Code, RETURN);
+}
+
+// inc
+static void Runtime_EmitInc(RuntimeBuild *Build)
+{
+    CodeBuf_Put(&Build->Code, POP_QWORD);
+    CodeBuf_PutAddress(&Build->Code, REGISTER64_A);
+
+    CodeBuf_Put(&Build->Code, LOAD_QWORD);
+    CodeBuf_PutAddress(&Build->Code, REGISTER64_B);
+    CodeBuf_PutQWord(&Build->Code, 1);
+
+    CodeBuf_Put(&Build->Code, MOVE_QWORD);
+    CodeBuf_PutAddress(&Build->Code, REGISTER64_A);
+    Runtime_PutCodeAddress(Build, Build->Code.Position + 9);
+
+    CodeBuf_Put(&Build->Code, INC_QWORD);
+    CodeBuf_PutAddress(&Build->Code, 0);
+
+    // arguments already popped off the stack
+    CodeBuf_Put(&Build->Code, RETURN);
+}
+
+// strlen
+static void Runtime_EmitStrlen(RuntimeBuild *Build)
+{
+    CodeBuf_Put(&Build->Code, POP_QWORD);
+    CodeBuf_PutAddress(&Build->Code, REGISTER64_A);
+
+    // save original pointer to subtract later
+    CodeBuf_Put(&Build->Code, MOVE_QWORD);
+    CodeBuf_PutAddress(&Build->Code, REGISTER64_A);
+    CodeBuf_PutAddress(&Build->Code, REGISTER64_B);
+
+    QWord Label = Build->Code.Position;
+
+    CodeBuf_Put(&Build->Code, DEREF_BYTE);
+    CodeBuf_PutAddress(&Build->Code, REGISTER64_A);
+    CodeBuf_PutAddress(&Build->Code, REGISTER_A);
+
+    CodeBuf_Put(&Build->Code, SET_FLAGS_BYTE);
+    CodeBuf_PutAddress(&Build->Code, REGISTER_A);
+
+    CodeBuf_Put(&Build->Code, JUMP_IF_ZERO);
+
+    QWord Placeholder = Build->Code.Position;
+    Runtime_PutCodeAddress(Build, 0); //placeholder
+
+    CodeBuf_Put(&Build->Code, INC_QWORD);
+    CodeBuf_PutAddress(&Build->Code, REGISTER64_A);
+
+    CodeBuf_Put(&Build->Code, JUMP);
+    Runtime_PutCodeAddress(Build, Label);
+
+    CodeBuf_WriteQWord(&Build->Code, Placeholder, Build->Code.Position);
+    
+    CodeBuf_Put(&Build->Code, SUB_QWORD);
+    CodeBuf_PutAddress(&Build->Code, REGISTER64_A);
+    CodeBuf_PutAddress(&Build->Code, REGISTER64_A);
+    CodeBuf_PutAddress(&Build->Code, REGISTER64_B);
+
+    // arguments already popped off the stack
+    CodeBuf_Put(&Build->Code, RETURN);
+}
+
+// printf, %d %u %x and %s take the next argument, "%%" prints one '%' and anything else after a '%' is printed as is
+static void Runtime_EmitPrintf(RuntimeBuild *Build)
+{
+    static const struct
+    {
+        char Conv;
+        const char *Callee;
+    } Convs[] = { { 'u', "putdec" }, { 'x', "puthex" }, { 's', "puts" }, { 'd', "putdec" } };
+
+    CodeBuf_Put(&Build->Code, POP_QWORD);
+    CodeBuf_PutAddress(&Build->Code, REGISTER64_A);
+
+    QWord WhileLabel = Build->Code.Position;
+
+    CodeBuf_Put(&Build->Code, DEREF_BYTE);
+    CodeBuf_PutAddress(&Build->Code, REGISTER64_A);
+    CodeBuf_PutAddress(&Build->Code, REGISTER_A);
+
+    CodeBuf_Put(&Build->Code, SET_FLAGS_BYTE);
+    CodeBuf_PutAddress(&Build->Code, REGISTER_A);
+
+    CodeBuf_Put(&Build->Code, JUMP_IF_ZERO);
+
+    QWord WhilePlaceholder = Build->Code.Position;
+    Runtime_PutCodeAddress(Build, 0); // placeholder
+
+    CodeBuf_Put(&Build->Code, LOAD_BYTE);
+    CodeBuf_PutAddress(&Build->Code, REGISTER_B);
+    CodeBuf_Put(&Build->Code, '%');
+
+    CodeBuf_Put(&Build->Code, COMPARE_BYTE);
+    CodeBuf_Put(&Build->Code, REGISTER_A);
+    CodeBuf_Put(&Build->Code, REGISTER_B);
+
+    CodeBuf_Put(&Build->Code, TICK_FLAGS); // logical not
+    CodeBuf_Put(&Build->Code, JUMP_IF_EQUAL);
+
+    QWord PlainPlaceholder = Build->Code.Position;
+    Runtime_PutCodeAddress(Build, 0); // placeholder
+
+    // peek at whats after the '%'
+    CodeBuf_Put(&Build->Code, MOVE_QWORD);
+    CodeBuf_PutAddress(&Build->Code, REGISTER64_A);
+    CodeBuf_PutAddress(&Build->Code, REGISTER64_B);
+
+    CodeBuf_Put(&Build->Code, INC_QWORD);
+    CodeBuf_PutAddress(&Build->Code, REGISTER64_B);
+
+    CodeBuf_Put(&Build->Code, DEREF_BYTE);
+    CodeBuf_PutAddress(&Build->Code, REGISTER64_B);
+    CodeBuf_PutAddress(&Build->Code, REGISTER_C);
+
+    QWord ConvPlaceholders[sizeof(Convs) / sizeof(Convs[0]) + 1];
+    for (size_t i = 0; i <= sizeof(Convs) / sizeof(Convs[0]); i++)
+    {
+        CodeBuf_Put(&Build->Code, LOAD_BYTE);
+        CodeBuf_PutAddress(&Build->Code, REGISTER_B);
+        CodeBuf_Put(&Build->Code, (i < sizeof(Convs) / sizeof(Convs[0])) ? Convs[i].Conv : '%');
+
+        CodeBuf_Put(&Build->Code, COMPARE_BYTE);
+        CodeBuf_Put(&Build->Code, REGISTER_C);
+        CodeBuf_Put(&Build->Code, REGISTER_B);
+
+        CodeBuf_Put(&Build->Code, JUMP_IF_EQUAL);
+
+        ConvPlaceholders[i] = Build->Code.Position;
+        Runtime_PutCodeAddress(Build, 0); // placeholder
+    }
+
+    // a lone '%'
+    CodeBuf_Put(&Build->Code, JUMP);
+
+    QWord LonePlaceholder = Build->Code.Position;
+    Runtime_PutCodeAddress(Build, 0); // placeholder
+
+    QWord NextPlaceholders[sizeof(Convs) / sizeof(Convs[0])];
+    for (size_t i = 0; i < sizeof(Convs) / sizeof(Convs[0]); i++)
+    {
+        CodeBuf_WriteQWord(&Build->Code, ConvPlaceholders[i], Build->Code.Position);
+
+        // skip the conversion char, the argument goes under the format pointer while the callee runs
+        CodeBuf_Put(&Build->Code, MOVE_QWORD);
+        CodeBuf_PutAddress(&Build->Code, REGISTER64_B);
+        CodeBuf_PutAddress(&Build->Code, REGISTER64_A);
+
+        CodeBuf_Put(&Build->Code, POP_QWORD);
+        CodeBuf_PutAddress(&Build->Code, REGISTER64_B);
+
+        CodeBuf_Put(&Build->Code, PUSH_QWORD);
+        CodeBuf_PutAddress(&Build->Code, REGISTER64_A);
+
+        QWord PositivePlaceholder = 0;
+        if (Convs[i].Conv == 'd')
+        {
+            // negative, print the sign and the magnitude
+            CodeBuf_Put(&Build->Code, LOAD_QWORD);
+            CodeBuf_PutAddress(&Build->Code, SYSCALL_ARG1);
+            CodeBuf_PutQWord(&Build->Code, INT64_MAX);
+
+            PositivePlaceholder = Runtime_EmitJumpIfGreater(Build, REGISTER64_B, SYSCALL_ARG1, false);
+
+            CodeBuf_Put(&Build->Code, PUSH_QWORD);
+            CodeBuf_PutAddress(&Build->Code, REGISTER64_B);
+
+            CodeBuf_Put(&Build->Code, LOAD_BYTE);
+            CodeBuf_PutAddress(&Build->Code, REGISTER_A);
+            CodeBuf_Put(&Build->Code, '-');
+
+            Runtime_EmitAppend(Build, REGISTER_A);
+
+            CodeBuf_Put(&Build->Code, POP_QWORD);
+            CodeBuf_PutAddress(&Build->Code, REGISTER64_B);
+
+            CodeBuf_Put(&Build->Code, LOAD_QWORD);
+            CodeBuf_PutAddress(&Build->Code, SYSCALL_ARG1);
+            CodeBuf_PutQWord(&Build->Code, 0);
+
+            CodeBuf_Put(&Build->Code, SUB_QWORD);
+            CodeBuf_PutAddress(&Build->Code, REGISTER64_B);
+            CodeBuf_PutAddress(&Build->Code, SYSCALL_ARG1);
+            CodeBuf_PutAddress(&Build->Code, REGISTER64_B);
+
+            CodeBuf_WriteQWord(&Build->Code, PositivePlaceholder, Build->Code.Position);
+        }
+
+        CodeBuf_Put(&Build->Code, PUSH_QWORD);
+        CodeBuf_PutAddress(&Build->Code, REGISTER64_B);
+
+        CodeBuf_Put(&Build->Code, CALL);
+        Runtime_PutFuncAddress(Build, Convs[i].Callee);
+
+        CodeBuf_Put(&Build->Code, POP_QWORD);
+        CodeBuf_PutAddress(&Build->Code, REGISTER64_A);
+
+        CodeBuf_Put(&Build->Code, JUMP);
+
+        NextPlaceholders[i] = Build->Code.Position;
+        Runtime_PutCodeAddress(Build, 0); // placeholder
+    }
+
+    // "%%", skip the second one
+    CodeBuf_WriteQWord(&Build->Code, ConvPlaceholders[sizeof(Convs) / sizeof(Convs[0])], Build->Code.Position);
+
+    CodeBuf_Put(&Build->Code, MOVE_QWORD);
+    CodeBuf_PutAddress(&Build->Code, REGISTER64_B);
+    CodeBuf_PutAddress(&Build->Code, REGISTER64_A);
+
+    CodeBuf_WriteQWord(&Build->Code, PlainPlaceholder, Build->Code.Position);
+    CodeBuf_WriteQWord(&Build->Code, LonePlaceholder, Build->Code.Position);
+
+    Runtime_EmitAppend(Build, REGISTER_A);
+
+    for (size_t i = 0; i < sizeof(Convs) / sizeof(Convs[0]); i++)
+    {
+        CodeBuf_WriteQWord(&Build->Code, NextPlaceholders[i], Build->Code.Position);
+    }
+
+    CodeBuf_Put(&Build->Code, INC_QWORD);
+    CodeBuf_PutAddress(&Build->Code, REGISTER64_A);
+
+    CodeBuf_Put(&Build->Code, JUMP);
+    Runtime_PutCodeAddress(Build, WhileLabel);
+
+    CodeBuf_WriteQWord(&Build->Code, WhilePlaceholder, Build->Code.Position);
+
+    // arguments already popped off the stack
+    CodeBuf_Put(&Build->Code, RETURN);
+}
+
+// puts, same as printf without the formatting, no newline is added
+static void Runtime_EmitPuts(RuntimeBuild *Build)
+{
+    CodeBuf_Put(&Build->Code, POP_QWORD);
+    CodeBuf_PutAddress(&Build->Code, REGISTER64_A);
+
+    QWord WhileLabel = Build->Code.Position;
+
+    CodeBuf_Put(&Build->Code, DEREF_BYTE);
+    CodeBuf_PutAddress(&Build->Code, REGISTER64_A);
+    CodeBuf_PutAddress(&Build->Code, REGISTER_A);
+
+    CodeBuf_Put(&Build->Code, SET_FLAGS_BYTE);
+    CodeBuf_PutAddress(&Build->Code, REGISTER_A);
+
+    CodeBuf_Put(&Build->Code, JUMP_IF_ZERO);
+
+    QWord WhilePlaceholder = Build->Code.Position;
+    Runtime_PutCodeAddress(Build, 0); // placeholder
+
+    Runtime_EmitAppend(Build, REGISTER_A);
+
+    CodeBuf_Put(&Build->Code, INC_QWORD);
+    CodeBuf_PutAddress(&Build->Code, REGISTER64_A);
+
+    CodeBuf_Put(&Build->Code, JUMP);
+    Runtime_PutCodeAddress(Build, WhileLabel);
+
+    CodeBuf_WriteQWord(&Build->Code, WhilePlaceholder, Build->Code.Position);
+
+    // arguments already popped off the stack
+    CodeBuf_Put(&Build->Code, RETURN);
+}
+
+// putchar, the char is the low byte of the arg and stays in A as the return value
+static void Runtime_EmitPutchar(RuntimeBuild *Build)
+{
+    CodeBuf_Put(&Build->Code, POP_QWORD);
+    CodeBuf_PutAddress(&Build->Code, REGISTER64_A);
+
+    // the append compares its char as a byte, so hand it the low byte of the arg
+    CodeBuf_Put(&Build->Code, MOVE_DYNAMIC);
+    CodeBuf_PutAddress(&Build->Code, REGISTER64_A);
+    CodeBuf_Put(&Build->Code, 1);
+    CodeBuf_PutAddress(&Build->Code, REGISTER_A);
+    CodeBuf_Put(&Build->Code, 1);
+
+    Runtime_EmitAppend(Build, REGISTER_A);
+
+    // arguments already popped off the stack
+    CodeBuf_Put(&Build->Code, RETURN);
+}
+
+// flush, writes out whatever is buffered. only touches B so callers can keep going with A
+static void Runtime_EmitFlush(RuntimeBuild *Build)
+{
+    CodeBuf_Put(&Build->Code, LOAD_QWORD);
+    CodeBuf_PutAddress(&Build->Code, REGISTER64_B);
+    CodeBuf_PutQWord(&Build->Code, 0);
+
+    CodeBuf_Put(&Build->Code, COMPARE_QWORD);
+    Runtime_PutDataAddress(Build, RUNTIME_OUT_LENGTH);
+    CodeBuf_PutAddress(&Build->Code, REGISTER64_B);
+
+    CodeBuf_Put(&Build->Code, JUMP_IF_EQUAL);
+
+    QWord EmptyPlaceholder = Build->Code.Position;
+    Runtime_PutCodeAddress(Build, 0); // placeholder
+
+    CodeBuf_Put(&Build->Code, LOAD_QWORD);
+    CodeBuf_PutAddress(&Build->Code, SYSCALL_ARG1);
+    Runtime_PutDataAddress(Build, RUNTIME_OUT_BUFFER);
+
+    CodeBuf_Put(&Build->Code, MOVE_QWORD);
+    Runtime_PutDataAddress(Build, RUNTIME_OUT_LENGTH);
+    CodeBuf_PutAddress(&Build->Code, SYSCALL_ARG2);
+
+    CodeBuf_Put(&Build->Code, SYSCALL);
+    CodeBuf_Put(&Build->Code, SYSNUM_WRITE_OUT);
+    CodeBuf_PutAddress(&Build->Code, REGISTER64_B);
+
+    CodeBuf_Put(&Build->Code, LOAD_QWORD);
+    Runtime_PutDataAddress(Build, RUNTIME_OUT_LENGTH);
+    CodeBuf_PutQWord(&Build->Code, 0);
+
+    CodeBuf_WriteQWord(&Build->Code, EmptyPlaceholder, Build->Code.Position);
+
+    CodeBuf_Put(&Build->Code, RETURN);
+}
+
+// putdec, the unsigned value two digits at a time. each power of 100 is split into its tens and units
+// by subtraction, which gives the offset of the pair in the digit pair table
+static void Runtime_EmitPutDec(RuntimeBuild *Build)
+{
+    CodeBuf_Put(&Build->Code, POP_QWORD);
+    CodeBuf_PutAddress(&Build->Code, REGISTER64_B);
+
+    // C and D can hold locals of the caller
+    CodeBuf_Put(&Build->Code, PUSH_QWORD);
+    CodeBuf_PutAddress(&Build->Code, REGISTER64_C);
+
+    CodeBuf_Put(&Build->Code, PUSH_QWORD);
+    CodeBuf_PutAddress(&Build->Code, REGISTER64_D);
+
+    CodeBuf_Put(&Build->Code, MOVE_QWORD);
+    CodeBuf_PutAddress(&Build->Code, REGISTER64_B);
+    CodeBuf_PutAddress(&Build->Code, REGISTER64_C);
+
+    // only the even powers, 10^18 down to 10^0
+    Runtime_EmitSkipLeading(Build, RUNTIME_POW10, 18 * sizeof(QWord), 2 * sizeof(QWord));
+
+    // set while on the first pair, which drops its leading zero
+    CodeBuf_Put(&Build->Code, LOAD_BYTE);
+    CodeBuf_PutAddress(&Build->Code, REGISTER_C);
+    CodeBuf_Put(&Build->Code, 1);
+
+    QWord PairLabel = Build->Code.Position;
+
+    CodeBuf_Put(&Build->Code, LOAD_QWORD);
+    CodeBuf_PutAddress(&Build->Code, REGISTER64_A);
+    CodeBuf_PutQWord(&Build->Code, 0);
+
+    // tens, the next power up
+    CodeBuf_Put(&Build->Code, LOAD_QWORD);
+    CodeBuf_PutAddress(&Build->Code, REGISTER64_B);
+    CodeBuf_PutQWord(&Build->Code, sizeof(QWord));
+
+    CodeBuf_Put(&Build->Code, ADD_QWORD);
+    CodeBuf_PutAddress(&Build->Code, REGISTER64_B);
+    CodeBuf_PutAddress(&Build->Code, REGISTER64_D);
+    CodeBuf_PutAddress(&Build->Code, REGISTER64_B);
+
+    CodeBuf_Put(&Build->Code, DEREF_QWORD);
+    CodeBuf_PutAddress(&Build->Code, REGISTER64_B);
+    CodeBuf_PutAddress(&Build->Code, SYSCALL_ARG2);
+
+    CodeBuf_Put(&Build->Code, LOAD_QWORD);
+    CodeBuf_PutAddress(&Build->Code, SYSCALL_ARG1);
+    CodeBuf_PutQWord(&Build->Code, 20);
+
+    Runtime_EmitCountDigit(Build);
+
+    // units
+    CodeBuf_Put(&Build->Code, DEREF_QWORD);
+    CodeBuf_PutAddress(&Build->Code, REGISTER64_D);
+    CodeBuf_PutAddress(&Build->Code, SYSCALL_ARG2);
+
+    CodeBuf_Put(&Build->Code, LOAD_QWORD);
+    CodeBuf_PutAddress(&Build->Code, SYSCALL_ARG1);
+    CodeBuf_PutQWord(&Build->Code, 2);
+
+    Runtime_EmitCountDigit(Build);
+
+    CodeBuf_Put(&Build->Code, SET_FLAGS_BYTE);
+    CodeBuf_PutAddress(&Build->Code, REGISTER_C);
+
+    CodeBuf_Put(&Build->Code, JUMP_IF_ZERO);
+
+    QWord BothPlaceholder = Build->Code.Position;
+    Runtime_PutCodeAddress(Build, 0); // placeholder
+
+    CodeBuf_Put(&Build->Code, LOAD_BYTE);
+    CodeBuf_PutAddress(&Build->Code, REGISTER_C);
+    CodeBuf_Put(&Build->Code, 0);
+
+    // a pair below 10 is the first digit
+    CodeBuf_Put(&Build->Code, LOAD_QWORD);
+    CodeBuf_PutAddress(&Build->Code, SYSCALL_ARG1);
+    CodeBuf_PutQWord(&Build->Code, 20);
+
+    QWord TwoDigitPlaceholder = Runtime_EmitJumpIfGreater(Build, SYSCALL_ARG1, REGISTER64_A, false);
+
+    CodeBuf_Put(&Build->Code, LOAD_QWORD);
+    CodeBuf_PutAddress(&Build->Code, REGISTER64_B);
+    Runtime_PutDataAddress(Build, RUNTIME_DIGIT_PAIRS + 1);
+
+    CodeBuf_Put(&Build->Code, ADD_QWORD);
+    CodeBuf_PutAddress(&Build->Code, REGISTER64_A);
+    CodeBuf_PutAddress(&Build->Code, REGISTER64_A);
+    CodeBuf_PutAddress(&Build->Code, REGISTER64_B);
+
+    CodeBuf_Put(&Build->Code, JUMP);
+
+    QWord SecondPlaceholder = Build->Code.Position;
+    Runtime_PutCodeAddress(Build, 0); // placeholder
+
+    CodeBuf_WriteQWord(&Build->Code, BothPlaceholder, Build->Code.Position);
+    CodeBuf_WriteQWord(&Build->Code, TwoDigitPlaceholder, Build->Code.Position);
+
+    CodeBuf_Put(&Build->Code, LOAD_QWORD);
+    CodeBuf_PutAddress(&Build->Code, REGISTER64_B);
+    Runtime_PutDataAddress(Build, RUNTIME_DIGIT_PAIRS);
+
+    CodeBuf_Put(&Build->Code, ADD_QWORD);
+    CodeBuf_PutAddress(&Build->Code, REGISTER64_A);
+    CodeBuf_PutAddress(&Build->Code, REGISTER64_A);
+    CodeBuf_PutAddress(&Build->Code, REGISTER64_B);
+
+    CodeBuf_Put(&Build->Code, DEREF_BYTE);
+    CodeBuf_PutAddress(&Build->Code, REGISTER64_A);
+    CodeBuf_PutAddress(&Build->Code, REGISTER_A);
+
+    Runtime_EmitAppend(Build, REGISTER_A);
+
+    CodeBuf_Put(&Build->Code, INC_QWORD);
+    CodeBuf_PutAddress(&Build->Code, REGISTER64_A);
+
+    CodeBuf_WriteQWord(&Build->Code, SecondPlaceholder, Build->Code.Position);
+
+    CodeBuf_Put(&Build->Code, DEREF_BYTE);
+    CodeBuf_PutAddress(&Build->Code, REGISTER64_A);
+    CodeBuf_PutAddress(&Build->Code, REGISTER_A);
+
+    Runtime_EmitAppend(Build, REGISTER_A);
+
+    Runtime_EmitNextPower(Build, RUNTIME_POW10, 2 * sizeof(QWord), PairLabel);
+
+    CodeBuf_Put(&Build->Code, POP_QWORD);
+    CodeBuf_PutAddress(&Build->Code, REGISTER64_D);
+
+    CodeBuf_Put(&Build->Code, POP_QWORD);
+    CodeBuf_PutAddress(&Build->Code, REGISTER64_C);
+
+    // arguments already popped off the stack
+    CodeBuf_Put(&Build->Code, RETURN);
+}
+
+// puthex, the unsigned value in lowercase hex one digit at a time
+static void Runtime_EmitPutHex(RuntimeBuild *Build)
+{
+    CodeBuf_Put(&Build->Code, POP_QWORD);
+    CodeBuf_PutAddress(&Build->Code, REGISTER64_B);
+
+    // C and D can hold locals of the caller
+    CodeBuf_Put(&Build->Code, PUSH_QWORD);
+    CodeBuf_PutAddress(&Build->Code, REGISTER64_C);
+
+    CodeBuf_Put(&Build->Code, PUSH_QWORD);
+    CodeBuf_PutAddress(&Build->Code, REGISTER64_D);
+
+    CodeBuf_Put(&Build->Code, MOVE_QWORD);
+    CodeBuf_PutAddress(&Build->Code, REGISTER64_B);
+    CodeBuf_PutAddress(&Build->Code, REGISTER64_C);
+
+    Runtime_EmitSkipLeading(Build, RUNTIME_POW16, 15 * sizeof(QWord), sizeof(QWord));
+
+    QWord DigitLabel = Build->Code.Position;
+
+    CodeBuf_Put(&Build->Code, LOAD_QWORD);
+    CodeBuf_PutAddress(&Build->Code, REGISTER64_A);
+    Runtime_PutDataAddress(Build, RUNTIME_HEX_DIGITS);
+
+    CodeBuf_Put(&Build->Code, DEREF_QWORD);
+    CodeBuf_PutAddress(&Build->Code, REGISTER64_D);
+    CodeBuf_PutAddress(&Build->Code, SYSCALL_ARG2);
+
+    CodeBuf_Put(&Build->Code, LOAD_QWORD);
+    CodeBuf_PutAddress(&Build->Code, SYSCALL_ARG1);
+    CodeBuf_PutQWord(&Build->Code, 1);
+
+    Runtime_EmitCountDigit(Build);
+
+    CodeBuf_Put(&Build->Code, DEREF_BYTE);
+    CodeBuf_PutAddress(&Build->Code, REGISTER64_A);
+    CodeBuf_PutAddress(&Build->Code, REGISTER_A);
+
+    Runtime_EmitAppend(Build, REGISTER_A);
+
+    Runtime_EmitNextPower(Build, RUNTIME_POW16, sizeof(QWord), DigitLabel);
+
+    CodeBuf_Put(&Build->Code, POP_QWORD);
+    CodeBuf_PutAddress(&Build->Code, REGISTER64_D);
+
+    CodeBuf_Put(&Build->Code, POP_QWORD);
+    CodeBuf_PutAddress(&Build->Code, REGISTER64_C);
+
+    // arguments already popped off the stack
+    CodeBuf_Put(&Build->Code, RETURN);
+}
+
+// dumpstate
+static void Runtime_EmitDumpState(RuntimeBuild *Build)
+{
+    CodeBuf_Put(&Build->Code, DUMP_STATE);
+    CodeBuf_Put(&Build->Code, RETURN);
+}
+
+typedef struct
+{
+    const char *Name;
+    void (*Emit)(RuntimeBuild *Build);
+} Builtin;
+
+static const Builtin Runtime_Builtins[] =
+{
+    { "write", Runtime_EmitWrite },
+    { "inc", Runtime_EmitInc },
+    { "strlen", Runtime_EmitStrlen },
+    { "printf", Runtime_EmitPrintf },
+    { "puts", Runtime_EmitPuts },
+    { "putchar", Runtime_EmitPutchar },
+    { "dumpstate", Runtime_EmitDumpState },
+    { "flush", Runtime_EmitFlush },
+    { "putdec", Runtime_EmitPutDec },
+    { "puthex", Runtime_EmitPutHex },
+};
+
+#define RUNTIME_BUILTIN_COUNT (sizeof(Runtime_Builtins) / sizeof(Runtime_Builtins[0]))
+
+// First and Count are a run inside a list of Total, in 64 bits so a damaged blob cant wrap around
+static inline bool Runtime_InRange(QWord First, QWord Count, QWord Total)
+{
+    return First + Count <= Total;
+}
+
+// fnv-1a, continues from Hash so a file can be fed through in chunks
+static uint64_t Runtime_Hash(uint64_t Hash, const void *Bytes, size_t Length)
+{
+    const Byte *At = Bytes;
+    for (size_t i = 0; i < Length; i++)
+    {
+        Hash = (Hash ^ At[i]) * 0x100000001b3ull;
+    }
+    return Hash;
+}
+
+// a blob off the disk can be damaged or from another compiler, every function has to stay inside
+// its own code and only point at things that exist before any of it gets copied out
+static bool Runtime_Validate(const Runtime *Rt)
+{
+    if (Rt->FuncCount != RUNTIME_BUILTIN_COUNT)
+    {
+        return false;
+    }
+
+    for (uint32_t i = 0; i < Rt->FuncCount; i++)
+    {
+        const RuntimeFunc *Func = &Rt->Funcs[i];
+        if (strncmp(Func->Name, Runtime_Builtins[i].Name, RUNTIME_NAME_LENGTH) != 0
+            || !Runtime_InRange(Func->Offset, Func->Size, Rt->CodeSize)
+            || !Runtime_InRange(Func->FirstReloc, Func->RelocCount, Rt->RelocCount)
+            || !Runtime_InRange(Func->FirstCall, Func->CallCount, Rt->CallCount)
+            || !Runtime_InRange(Func->FirstData, Func->DataCount, Rt->DataRelocCount))
+        {
+            return false;
+        }
+
+        // operands are whole qwords inside the function
+        QWord End = (QWord)Func->Offset + Func->Size;
+        for (uint32_t j = 0; j < Func->RelocCount; j++)
+        {
+            uint32_t Position = Rt->Relocs[Func->FirstReloc + j];
+            if (Position < Func->Offset || Position + sizeof(QWord) > End)
+            {
+                return false;
+            }
+
+            QWord Address;
+            memcpy(&Address, Rt->Code + Position, sizeof(QWord));
+            if (Address < Func->Offset || Address > End)
+            {
+                return false;
+            }
+        }
+
+        for (uint32_t j = 0; j < Func->CallCount; j++)
+        {
+            const RuntimeCall *Call = &Rt->Calls[Func->FirstCall + j];
+            if (Call->Position < Func->Offset || Call->Position + sizeof(QWord) > End || Call->Callee >= Rt->FuncCount)
+            {
+                return false;
+            }
+        }
+
+        for (uint32_t j = 0; j < Func->DataCount; j++)
+        {
+            uint32_t Position = Rt->DataRelocs[Func->FirstData + j];
+            if (Position < Func->Offset || Position + sizeof(QWord) > End)
+            {
+                return false;
+            }
+
+            QWord Offset;
+            memcpy(&Offset, Rt->Code + Position, sizeof(QWord));
+            if (Offset >= RUNTIME_DATA_SIZE)
+            {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+// points the lists into the blob, false if it isnt one of ours
+static bool Runtime_Attach(Runtime *Rt, void *Blob, size_t Size, uint64_t Compiler)
+{
+    const RuntimeHeader *Header = Blob;
+    if (Size < sizeof(RuntimeHeader)
+        || Header->Magic != RUNTIME_MAGIC
+        || Header->Version != RUNTIME_VERSION
+        || Header->Compiler != Compiler
+        || Header->Hash != Runtime_Hash(RUNTIME_HASH_SEED, Header + 1, Size - sizeof(RuntimeHeader)))
+    {
+        return false;
+    }
+
+    size_t Expected = sizeof(RuntimeHeader)
+        + Header->FuncCount * sizeof(RuntimeFunc)
+        + Header->RelocCount * sizeof(uint32_t)
+        + Header->CallCount * sizeof(RuntimeCall)
+        + Header->DataRelocCount * sizeof(uint32_t)
+        + Header->CodeSize
+        + RUNTIME_DATA_SIZE;
+    if (Size != Expected)
+    {
+        return false;
+    }
+
+    const Byte *At = (const Byte *)(Header + 1);
+    Rt->Funcs = (const RuntimeFunc *)At;
+    Rt->FuncCount = Header->FuncCount;
+    At += Header->FuncCount * sizeof(RuntimeFunc);
+    Rt->Relocs = (const uint32_t *)At;
+    Rt->RelocCount = Header->RelocCount;
+    At += Header->RelocCount * sizeof(uint32_t);
+    Rt->Calls = (const RuntimeCall *)At;
+    Rt->CallCount = Header->CallCount;
+    At += Header->CallCount * sizeof(RuntimeCall);
+    Rt->DataRelocs = (const uint32_t *)At;
+    Rt->DataRelocCount = Header->DataRelocCount;
+    At += Header->DataRelocCount * sizeof(uint32_t);
+    Rt->Code = At;
+    Rt->CodeSize = Header->CodeSize;
+    At += Header->CodeSize;
+    Rt->Data = At;
+    Rt->Blob = Blob;
+
+    if (!Runtime_Validate(Rt))
+    {
+        *Rt = (Runtime) {0};
+        return false;
+    }
+    return true;
+}
+
+// the buffer starts out empty, the tables are what putdec and puthex look things up in
+static void Runtime_FillData(Byte *Data)
+{
+    memset(Data, 0, RUNTIME_DATA_SIZE);
+
+    QWord Pow10 = 1;
+    for (int i = 0; i < 20; i++, Pow10 *= 10)
+    {
+        memcpy(Data + RUNTIME_POW10 + i * sizeof(QWord), &Pow10, sizeof(QWord));
+    }
+
+    QWord Pow16 = 1;
+    for (int i = 0; i < 16; i++, Pow16 *= 16)
+    {
+        memcpy(Data + RUNTIME_POW16 + i * sizeof(QWord), &Pow16, sizeof(QWord));
+    }
+
+    for (int i = 0; i < 100; i++)
+    {
+        Data[RUNTIME_DIGIT_PAIRS + i * 2] = '0' + i / 10;
+        Data[RUNTIME_DIGIT_PAIRS + i * 2 + 1] = '0' + i % 10;
+    }
+
+    memcpy(Data + RUNTIME_HEX_DIGITS, "0123456789abcdef", 16);
+}
+
+// emits every builtin back to back and packs the result the same way its cached
+static void *Runtime_Build(size_t *Size, uint64_t Compiler)
+{
+    RuntimeBuild Build = {0};
+    RuntimeFunc Funcs[RUNTIME_BUILTIN_COUNT] = {0};
+
+    for (uint32_t i = 0; i < RUNTIME_BUILTIN_COUNT; i++)
+    {
+        RuntimeFunc *Func = &Funcs[i];
+        strncpy(Func->Name, Runtime_Builtins[i].Name, RUNTIME_NAME_LENGTH - 1);
+        Func->Offset = (uint32_t)Build.Code.Position;
+        Func->FirstReloc = Build.RelocCount;
+        Func->FirstCall = Build.CallCount;
+        Func->FirstData = Build.DataRelocCount;
+
+        Runtime_Builtins[i].Emit(&Build);
+
+        Func->Size = (uint32_t)Build.Code.Position - Func->Offset;
+        Func->RelocCount = Build.RelocCount - Func->FirstReloc;
+        Func->CallCount = Build.CallCount - Func->FirstCall;
+        Func->DataCount = Build.DataRelocCount - Func->FirstData;
+    }
+
+    RuntimeHeader Header = { RUNTIME_MAGIC, RUNTIME_VERSION, Compiler, 0, RUNTIME_BUILTIN_COUNT, Build.RelocCount, Build.CallCount, Build.DataRelocCount, (uint32_t)Build.Code.Position };
+
+    *Size = sizeof(RuntimeHeader)
+        + sizeof(Funcs)
+        + Build.RelocCount * sizeof(uint32_t)
+        + Build.CallCount * sizeof(RuntimeCall)
+        + Build.DataRelocCount * sizeof(uint32_t)
+        + Build.Code.Position
+        + RUNTIME_DATA_SIZE;
+    Byte *Blob = malloc(*Size);
+    Byte *At = Blob;
+
+    At += sizeof(Header);
+    memcpy(At, Funcs, sizeof(Funcs));
+    At += sizeof(Funcs);
+    memcpy(At, Build.Relocs, Build.RelocCount * sizeof(uint32_t));
+    At += Build.RelocCount * sizeof(uint32_t);
+
+    for (uint32_t i = 0; i < Build.CallCount; i++)
+    {
+        uint32_t Callee = 0;
+        while (strcmp(Runtime_Builtins[Callee].Name, Build.Calls[i].Callee) != 0)
+        {
+            Callee++; // only ever names from the table above
+        }
+
+        RuntimeCall Call = { Build.Calls[i].Position, Callee };
+        memcpy(At, &Call, sizeof(Call));
+        At += sizeof(Call);
+    }
+
+    memcpy(At, Build.DataRelocs, Build.DataRelocCount * sizeof(uint32_t));
+    At += Build.DataRelocCount * sizeof(uint32_t);
+    memcpy(At, Build.Code.Data, Build.Code.Position);
+    At += Build.Code.Position;
+    Runtime_FillData(At);
+
+    Header.Hash = Runtime_Hash(RUNTIME_HASH_SEED, Blob + sizeof(Header), *Size - sizeof(Header));
+    memcpy(Blob, &Header, sizeof(Header));
+
+    CodeBuf_Free(&Build.Code);
+    free(Build.Relocs);
+    free(Build.Calls);
+    free(Build.DataRelocs);
+    return Blob;
+}
+
+static bool Runtime_FindExe(const char *ExePath, char *Exe, size_t Capacity)
+{
+    // argv[0] has no directory when the compiler was found through PATH
+    ssize_t Length = readlink("/proc/self/exe", Exe, Capacity - 1);
+    if (Length <= 0)
+    {
+        Length = (ssize_t)strlen(ExePath);
+        if ((size_t)Length >= Capacity)
+        {
+            return false;
+        }
+        memcpy(Exe, ExePath, Length);
+    }
+    Exe[Length] = '\0';
+    return true;
+}
+
+// the emitters are compiled into the executable, so a blob is only reused by the same file. one stat
+// keeps the check flat no matter how big the compiler gets, a rebuilt or replaced one gets a new mtime or inode
+static bool Runtime_KeyExe(const char *Exe, uint64_t *Key)
+{
+    struct stat Info;
+    if (stat(Exe, &Info) != 0)
+    {
+        return false;
+    }
+
+    uint64_t Fields[] = { RUNTIME_VERSION, (uint64_t)Info.st_dev, (uint64_t)Info.st_ino, (uint64_t)Info.st_size,
+        (uint64_t)Info.st_mtim.tv_sec, (uint64_t)Info.st_mtim.tv_nsec };
+    *Key = Runtime_Hash(RUNTIME_HASH_SEED, Fields, sizeof(Fields));
+    return true;
+}
+
+static void *Runtime_ReadCache(const char *Path, size_t *Size)
+{
+    FILE *In = fopen(Path, "rb");
+    if (!In)
+    {
+        return NULL;
+    }
+
+    void *Blob = NULL;
+    long Length;
+    if (fseek(In, 0, SEEK_END) == 0 && (Length = ftell(In)) > 0 && fseek(In, 0, SEEK_SET) == 0)
+    {
+        Blob = malloc(Length);
+        if (fread(Blob, 1, Length, In) != (size_t)Length)
+        {
+            free(Blob);
+            Blob = NULL;
+        }
+        *Size = (size_t)Length;
+    }
+
+    fclose(In);
+    return Blob;
+}
+
+// written next to it and renamed over, so a compile running at the same time never sees half a blob
+static void Runtime_WriteCache(const char *Path, const void *Blob, size_t Size)
+{
+    size_t PathLength = strlen(Path);
+    char *Temp = malloc(PathLength + 32);
+    snprintf(Temp, PathLength + 32, "%s.%ld", Path, (long)getpid());
+
+    FILE *Out = fopen(Temp, "wb");
+    if (Out)
+    {
+        bool Ok = fwrite(Blob, 1, Size, Out) == Size;
+        if ((fclose(Out) == 0) && Ok && rename(Temp, Path) == 0)
+        {
+            free(Temp);
+            return;
+        }
+        remove(Temp);
+    }
+
+    // not being able to cache only costs the next compile the rebuild
+    free(Temp);
+}
+
+bool Runtime_Load(Runtime *Rt, const char *ExePath)
+{
+    // without the executable there is nothing to key the cache on, so the blob is only built in memory
+    char Path[4096];
+    uint64_t Compiler = 0;
+    bool Cached = Runtime_FindExe(ExePath, Path, sizeof(Path) - sizeof(".rt"))
+        && Runtime_KeyExe(Path, &Compiler);
+    if (Cached)
+    {
+        strcat(Path, ".rt");
+    }
+
+    size_t Size = 0;
+    void *Blob = Cached ? Runtime_ReadCache(Path, &Size) : NULL;
+    if (Blob && Runtime_Attach(Rt, Blob, Size, Compiler))
+    {
+        return true;
+    }
+    free(Blob);
+
+    Blob = Runtime_Build(&Size, Compiler);
+    if (Cached)
+    {
+        Runtime_WriteCache(Path, Blob, Size);
+    }
+
+    if (!Runtime_Attach(Rt, Blob, Size, Compiler))
+    {
+        free(Blob);
+        return false;
+    }
+    return true;
+}
+
+void Runtime_Free(Runtime *Rt)
+{
+    free(Rt->Blob);
+    *Rt = (Runtime) {0};
+}
@@ -0,0 +1,70 @@
+#ifndef RUNTIME_H
+#define RUNTIME_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "CodeBuffer.h"
+
+#define RUNTIME_MAGIC 0x4d525246 // "FRRM"
+#define RUNTIME_VERSION 4 // bump when the layout of the blob changes
+#define RUNTIME_NAME_LENGTH 16
+
+// the runtime's own data, placed after the strings when a builtin that uses it is reached.
+// the output buffer comes first, the number formatting tables after it
+#define RUNTIME_OUT_LENGTH 0
+#define RUNTIME_OUT_LINE_BUFFERED 8 // set by the compiler, FCC_STDOUT=line
+#define RUNTIME_OUT_BUFFER 16
+#define RUNTIME_OUT_CAPACITY 1024
+#define RUNTIME_POW10 (RUNTIME_OUT_BUFFER + RUNTIME_OUT_CAPACITY) // 10^0 .. 10^19
+#define RUNTIME_POW16 (RUNTIME_POW10 + 20 * 8) // 16^0 .. 16^15
+#define RUNTIME_DIGIT_PAIRS (RUNTIME_POW16 + 16 * 8) // "00" .. "99"
+#define RUNTIME_HEX_DIGITS (RUNTIME_DIGIT_PAIRS + 200)
+#define RUNTIME_DATA_SIZE (RUNTIME_HEX_DIGITS + 16)
+
+// one builtin inside the blob, its relocs and calls are contiguous runs of the blob's lists
+typedef struct
+{
+    char Name[RUNTIME_NAME_LENGTH];
+    uint32_t Offset;
+    uint32_t Size;
+    uint32_t FirstReloc;
+    uint32_t RelocCount;
+    uint32_t FirstCall;
+    uint32_t CallCount;
+    uint32_t FirstData;
+    uint32_t DataCount;
+} RuntimeFunc;
+
+// an operand holding the address of another builtin
+typedef struct
+{
+    uint32_t Position;
+    uint32_t Callee; // index into Funcs
+} RuntimeCall;
+
+// the builtins compiled once at address 0 and cached next to the compiler.
+// Relocs are operands holding an address inside their own function,
+// DataRelocs are operands holding an offset into the runtime's data
+typedef struct
+{
+    const RuntimeFunc *Funcs;
+    uint32_t FuncCount;
+    const uint32_t *Relocs;
+    uint32_t RelocCount;
+    const RuntimeCall *Calls;
+    uint32_t CallCount;
+    const uint32_t *DataRelocs;
+    uint32_t DataRelocCount;
+    const Byte *Code;
+    uint32_t CodeSize;
+    const Byte *Data; // RUNTIME_DATA_SIZE bytes to copy in as is
+
+    void *Blob; // everything above points in here
+} Runtime;
+
+// reads the cached blob next to the executable, building and caching it first if its missing or stale
+bool Runtime_Load(Runtime *Rt, const char *ExePath);
+
+void Runtime_Free(Runtime *Rt);
+
+#endif // RUNTIME_H
@@ -0,0 +1,110 @@
+#include "Source.h"
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define SOURCE_CHUNK_LEN 65536
+
+// fallback for things we cant mmap (pipes, stdin, ttys)
+static bool Source_ReadChunks(Source *Src, int Fd)
+{
+    char *Data = NULL;
+    size_t Capacity = 0;
+    size_t Length = 0;
+
+    for (;;)
+    {
+        if (Length == Capacity)
+        {
+            Capacity += (Capacity == 0) ? SOURCE_CHUNK_LEN : Capacity;
+            char *NewData = realloc(Data, Capacity);
+            if (NewData == NULL)
+            {
+                free(Data);
+                return false;
+            }
+            Data = NewData;
+        }
+
+        ssize_t BytesRead = read(Fd, Data + Length, Capacity - Length);
+        if (BytesRead < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            free(Data);
+            return false;
+        }
+        if (BytesRead == 0)
+        {
+            break; // eof
+        }
+        Length += BytesRead;
+    }
+
+    Src->Data = Data;
+    Src->Length = Length;
+    Src->Mapped = false;
+    return true;
+}
+
+bool Source_Open(Source *Src, const char *Path)
+{
+    Src->Data = NULL;
+    Src->Length = 0;
+    Src->Mapped = false;
+
+    bool IsStdin = (strcmp(Path, "-") == 0);
+    int Fd = IsStdin ? STDIN_FILENO : open(Path, O_RDONLY);
+    if (Fd < 0)
+    {
+        return false;
+    }
+
+    struct stat Stat;
+    if (fstat(Fd, &Stat) == 0 && S_ISREG(Stat.st_mode) && Stat.st_size > 0)
+    {
+        void *Map = mmap(NULL, Stat.st_size, PROT_READ, MAP_PRIVATE, Fd, 0);
+        if (Map != MAP_FAILED)
+        {
+            madvise(Map, Stat.st_size, MADV_SEQUENTIAL);
+            Src->Data = Map;
+            Src->Length = Stat.st_size;
+            Src->Mapped = true;
+
+            if (!IsStdin)
+            {
+                close(Fd);
+            }
+            return true;
+        }
+    }
+
+    bool Ok = Source_ReadChunks(Src, Fd);
+    if (!IsStdin)
+    {
+        close(Fd);
+    }
+    return Ok;
+}
+
+void Source_Close(Source *Src)
+{
+    if (Src->Mapped)
+    {
+        munmap((void *)Src->Data, Src->Length);
+    }
+    else
+    {
+        free((void *)Src->Data);
+    }
+
+    Src->Data = NULL;
+    Src->Length = 0;
+    Src->Mapped = false;
+}
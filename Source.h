@@ -0,0 +1,19 @@
+#ifndef SOURCE_H
+#define SOURCE_H
+
+#include <stdlib.h>
+#include <stdbool.h>
+
+typedef struct
+{
+    const char *Data; // not null terminated, use Length
+    size_t Length;
+    bool Mapped; // mmapped file vs heap buffer read from a pipe/stdin
+} Source;
+
+// Path "-" reads from stdin
+bool Source_Open(Source *Src, const char *Path);
+
+void Source_Close(Source *Src);
+
+#endif // SOURCE_H
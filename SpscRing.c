@@ -0,0 +1,57 @@
+#include "SpscRing.h"
+#include <sched.h>
+
+#define SPSC_SPINS 256 // busy waits before giving the core away
+
+void SpscRing_Init(SpscRing *Ring, size_t SlotSize, size_t Capacity)
+{
+    Ring->Slots = calloc(Capacity, SlotSize);
+    Ring->SlotSize = SlotSize;
+    Ring->Capacity = Capacity;
+    atomic_init(&Ring->Head, 0);
+    atomic_init(&Ring->Tail, 0);
+}
+
+void *SpscRing_PushSlot(SpscRing *Ring)
+{
+    size_t Tail = atomic_load_explicit(&Ring->Tail, memory_order_relaxed);
+    for (size_t Spins = 0; Tail - atomic_load_explicit(&Ring->Head, memory_order_acquire) == Ring->Capacity; Spins++)
+    {
+        if (Spins >= SPSC_SPINS)
+        {
+            sched_yield();
+        }
+    }
+    return SpscRing_Slot(Ring, Tail);
+}
+
+void SpscRing_Push(SpscRing *Ring)
+{
+    size_t Tail = atomic_load_explicit(&Ring->Tail, memory_order_relaxed);
+    atomic_store_explicit(&Ring->Tail, Tail + 1, memory_order_release);
+}
+
+void *SpscRing_PopSlot(SpscRing *Ring)
+{
+    size_t Head = atomic_load_explicit(&Ring->Head, memory_order_relaxed);
+    for (size_t Spins = 0; atomic_load_explicit(&Ring->Tail, memory_order_acquire) == Head; Spins++)
+    {
+        if (Spins >= SPSC_SPINS)
+        {
+            sched_yield();
+        }
+    }
+    return SpscRing_Slot(Ring, Head);
+}
+
+void SpscRing_Pop(SpscRing *Ring)
+{
+    size_t Head = atomic_load_explicit(&Ring->Head, memory_order_relaxed);
+    atomic_store_explicit(&Ring->Head, Head + 1, memory_order_release);
+}
+
+void SpscRing_Free(SpscRing *Ring)
+{
+    free(Ring->Slots);
+    Ring->Slots = NULL;
+}
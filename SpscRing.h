@@ -0,0 +1,38 @@
+#ifndef SPSCRING_H
+#define SPSCRING_H
+
+#include <stdlib.h>
+#include <stdatomic.h>
+
+// single producer single consumer ring of fixed size slots, no locks,
+// slots are filled and read in place so big payloads never get copied
+typedef struct
+{
+    unsigned char *Slots;
+    size_t SlotSize;
+    size_t Capacity; // power of 2
+
+    // own cache lines so the two threads dont keep taking them from each other
+    _Alignas(64) atomic_size_t Head; // next slot to pop, only the consumer writes it
+    _Alignas(64) atomic_size_t Tail; // next slot to push, only the producer writes it
+} SpscRing;
+
+// slots start out zeroed
+void SpscRing_Init(SpscRing *Ring, size_t SlotSize, size_t Capacity);
+
+static inline void *SpscRing_Slot(SpscRing *Ring, size_t Index)
+{
+    return Ring->Slots + (Index & (Ring->Capacity - 1)) * Ring->SlotSize;
+}
+
+// producer: waits for a free slot, fill it in and then publish it with SpscRing_Push
+void *SpscRing_PushSlot(SpscRing *Ring);
+void SpscRing_Push(SpscRing *Ring);
+
+// consumer: waits for a published slot, once done with it hand it back with SpscRing_Pop
+void *SpscRing_PopSlot(SpscRing *Ring);
+void SpscRing_Pop(SpscRing *Ring);
+
+void SpscRing_Free(SpscRing *Ring);
+
+#endif // SPSCRING_H
@@ -0,0 +1,158 @@
+#include "StringPool.h"
+#include "Lexer.h"
+
+static inline uint32_t StringPool_Hash(const char *Bytes, size_t Length)
+{
+    // fnv-1a
+    uint32_t Hash = 2166136261u;
+    for (size_t i = 0; i < Length; i++)
+    {
+        Hash ^= (unsigned char)Bytes[i];
+        Hash *= 16777619u;
+    }
+    return Hash;
+}
+
+static void StringPool_Rehash(StringPool *Pool, size_t NewBucketCount)
+{
+    free(Pool->Buckets);
+    Pool->Buckets = calloc(NewBucketCount, sizeof(uint32_t));
+    Pool->BucketCount = NewBucketCount;
+
+    size_t Mask = NewBucketCount - 1;
+    for (uint32_t i = 0; i < Pool->Count; i++)
+    {
+        size_t Slot = Pool->Strings[i].Hash & Mask;
+        while (Pool->Buckets[Slot] != 0)
+        {
+            Slot = (Slot + 1) & Mask;
+        }
+        Pool->Buckets[Slot] = i + 1;
+    }
+}
+
+uint32_t StringPool_Add(StringPool *Pool, InternTable *Interns, InternId Literal)
+{
+    if (Literal < Pool->InternCapacity && Pool->ByIntern[Literal])
+    {
+        return Pool->ByIntern[Literal] - 1;
+    }
+
+    if (Literal >= Pool->InternCapacity)
+    {
+        size_t NewCapacity = (Pool->InternCapacity == 0) ? 256 : Pool->InternCapacity;
+        while (NewCapacity <= Literal)
+        {
+            NewCapacity *= 2;
+        }
+        Pool->ByIntern = realloc(Pool->ByIntern, NewCapacity * sizeof(uint32_t));
+        memset(Pool->ByIntern + Pool->InternCapacity, 0, (NewCapacity - Pool->InternCapacity) * sizeof(uint32_t));
+        Pool->InternCapacity = NewCapacity;
+    }
+
+    // first time we see this spelling, decode the escapes now
+    StrView Raw = Intern_View(Interns, Literal);
+    size_t Length = Lexer_Unescape(Raw, NULL, 0);
+    char *Bytes = Arena_Alloc(&Pool->Mem, Length + 1);
+    Lexer_Unescape(Raw, Bytes, Length);
+    Bytes[Length] = 0;
+
+    uint32_t Hash = StringPool_Hash(Bytes, Length);
+
+    if ((Pool->Count + 1) * 2 > Pool->BucketCount)
+    {
+        StringPool_Rehash(Pool, (Pool->BucketCount == 0) ? 64 : (Pool->BucketCount * 2));
+    }
+
+    size_t Mask = Pool->BucketCount - 1;
+    size_t Slot = Hash & Mask;
+    while (Pool->Buckets[Slot] != 0)
+    {
+        PoolString *Str = &Pool->Strings[Pool->Buckets[Slot] - 1];
+        if (Str->Hash == Hash && Str->Length == Length && memcmp(Str->Bytes, Bytes, Length) == 0)
+        {
+            // same bytes spelled differently, the copy we just made is simply left in the arena
+            Pool->ByIntern[Literal] = Pool->Buckets[Slot];
+            return Pool->Buckets[Slot] - 1;
+        }
+        Slot = (Slot + 1) & Mask;
+    }
+
+    if (Pool->Count == Pool->Capacity)
+    {
+        Pool->Capacity = (Pool->Capacity == 0) ? 64 : (Pool->Capacity * 2);
+        Pool->Strings = realloc(Pool->Strings, Pool->Capacity * sizeof(PoolString));
+    }
+
+    Pool->Strings[Pool->Count] = (PoolString) { Bytes, Length, Hash, 0 };
+    Pool->Buckets[Slot] = ++Pool->Count;
+    Pool->ByIntern[Literal] = Pool->Count;
+    return Pool->Count - 1;
+}
+
+// orders by the bytes read back to front, so a string comes right before the ones it is a tail of
+static int StringPool_CompareReversed(const void *A, const void *B)
+{
+    const PoolString *StrA = *(const PoolString **)A;
+    const PoolString *StrB = *(const PoolString **)B;
+
+    size_t Length = (StrA->Length < StrB->Length) ? StrA->Length : StrB->Length;
+    for (size_t i = 1; i <= Length; i++)
+    {
+        unsigned char CharA = StrA->Bytes[StrA->Length - i];
+        unsigned char CharB = StrB->Bytes[StrB->Length - i];
+        if (CharA != CharB)
+        {
+            return (CharA < CharB) ? -1 : 1;
+        }
+    }
+    return (StrA->Length > StrB->Length) - (StrA->Length < StrB->Length);
+}
+
+static inline bool StringPool_IsTail(const PoolString *Tail, const PoolString *Of)
+{
+    return Tail->Length <= Of->Length && memcmp(Of->Bytes + (Of->Length - Tail->Length), Tail->Bytes, Tail->Length) == 0;
+}
+
+size_t StringPool_Layout(StringPool *Pool, char **Data)
+{
+    PoolString **Sorted = malloc(Pool->Count * sizeof(PoolString *) + 1);
+    for (uint32_t i = 0; i < Pool->Count; i++)
+    {
+        Sorted[i] = &Pool->Strings[i];
+    }
+    qsort(Sorted, Pool->Count, sizeof(PoolString *), StringPool_CompareReversed);
+
+    // the last of every run of tails is the longest, it gets the bytes and the rest point into it
+    size_t Size = 0;
+    for (uint32_t i = Pool->Count; i-- > 0;)
+    {
+        if (i + 1 < Pool->Count && StringPool_IsTail(Sorted[i], Sorted[i + 1]))
+        {
+            Sorted[i]->Offset = Sorted[i + 1]->Offset + (Sorted[i + 1]->Length - Sorted[i]->Length);
+        }
+        else
+        {
+            Sorted[i]->Offset = Size;
+            Size += Sorted[i]->Length + 1; // null terminator
+        }
+    }
+
+    *Data = malloc(Size + 1);
+    for (uint32_t i = 0; i < Pool->Count; i++)
+    {
+        memcpy(*Data + Sorted[i]->Offset, Sorted[i]->Bytes, Sorted[i]->Length + 1);
+    }
+
+    free(Sorted);
+    return Size;
+}
+
+void StringPool_Free(StringPool *Pool)
+{
+    free(Pool->Strings);
+    free(Pool->ByIntern);
+    free(Pool->Buckets);
+    Arena_Free(&Pool->Mem);
+    *Pool = (StringPool) {0};
+}
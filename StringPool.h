@@ -0,0 +1,41 @@
+#ifndef STRINGPOOL_H
+#define STRINGPOOL_H
+
+#include <stdint.h>
+#include "Arena.h"
+#include "Intern.h"
+
+typedef struct
+{
+    const char *Bytes; // unescaped and null terminated
+    size_t Length; // without the terminator
+    uint32_t Hash;
+    size_t Offset; // into the data section, set by StringPool_Layout
+} PoolString;
+
+// every string literal once by content, no matter how it was spelled
+typedef struct
+{
+    PoolString *Strings;
+    uint32_t Count;
+    uint32_t Capacity;
+
+    uint32_t *ByIntern; // literal intern id -> index + 1, so each spelling is only unescaped once
+    size_t InternCapacity;
+
+    uint32_t *Buckets; // open addressing on the content hash, index + 1, 0 is empty
+    size_t BucketCount; // power of 2
+
+    Arena Mem; // the bytes
+} StringPool;
+
+// index of the literal's string, adding it the first time
+uint32_t StringPool_Add(StringPool *Pool, InternTable *Interns, InternId Literal);
+
+// gives every string its offset, strings that are the tail of a longer one live inside it.
+// returns the size of the data section
+size_t StringPool_Layout(StringPool *Pool, char **Data);
+
+void StringPool_Free(StringPool *Pool);
+
+#endif // STRINGPOOL_H
@@ -0,0 +1,78 @@
+#include "SymTable.h"
+#include <string.h>
+
+void SymTable_PushScope(SymTable *Table)
+{
+    if (Table->ScopeCount == Table->ScopeCapacity)
+    {
+        Table->ScopeCapacity = (Table->ScopeCapacity == 0) ? 16 : (Table->ScopeCapacity * 2);
+        Table->Scopes = realloc(Table->Scopes, Table->ScopeCapacity * sizeof(Scope));
+    }
+
+    Table->Scopes[Table->ScopeCount++] = (Scope) { Arena_Mark(&Table->Mem), NULL };
+}
+
+void SymTable_PopScope(SymTable *Table)
+{
+    if (Table->ScopeCount == 0)
+    {
+        return;
+    }
+
+    Scope *Top = &Table->Scopes[--Table->ScopeCount];
+
+    // newest first, so names declared twice in one scope unwind back to the outer meaning
+    for (VarNode *Var = Top->Vars; Var; Var = Var->Next)
+    {
+        Table->ByName[Var->Name] = Var->Shadowed;
+    }
+
+    Arena_Release(&Table->Mem, Top->Mark);
+}
+
+VarNode *SymTable_Define(SymTable *Table, InternId Name)
+{
+    if (Table->ScopeCount == 0)
+    {
+        SymTable_PushScope(Table);
+    }
+
+    if (Name >= Table->Capacity)
+    {
+        size_t OldCapacity = Table->Capacity;
+        Table->Capacity = (Table->Capacity == 0) ? 256 : Table->Capacity;
+        while (Name >= Table->Capacity)
+        {
+            Table->Capacity *= 2;
+        }
+        Table->ByName = realloc(Table->ByName, Table->Capacity * sizeof(VarNode *));
+        memset(&Table->ByName[OldCapacity], 0, (Table->Capacity - OldCapacity) * sizeof(VarNode *));
+    }
+
+    Scope *Top = &Table->Scopes[Table->ScopeCount - 1];
+
+    VarNode *Var = Arena_Alloc(&Table->Mem, sizeof(VarNode));
+    memset(Var, 0, sizeof(VarNode));
+    Var->Name = Name;
+    Var->Shadowed = Table->ByName[Name];
+    Var->Next = Top->Vars;
+
+    Top->Vars = Var;
+    Table->ByName[Name] = Var;
+    return Var;
+}
+
+Function *SymTable_NewFunc(SymTable *Table)
+{
+    Function *Func = Arena_Alloc(&Table->Mem, sizeof(Function));
+    memset(Func, 0, sizeof(Function));
+    return Func;
+}
+
+void SymTable_Free(SymTable *Table)
+{
+    free(Table->ByName);
+    free(Table->Scopes);
+    Arena_Free(&Table->Mem);
+    memset(Table, 0, sizeof(SymTable));
+}
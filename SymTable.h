@@ -0,0 +1,69 @@
+#ifndef SYMTABLE_H
+#define SYMTABLE_H
+
+#include "Arena.h"
+#include "Parser.h"
+
+#include "../furnvm/BytecodeBuilder.h"
+
+typedef struct
+{
+    size_t Label; // 0 until its code is emitted, builtins only get one if something reaches them
+    uint32_t ParamCount;
+    TypeDesc ReturnType;
+    uint32_t Builtin; // index + 1 into the runtime's functions, 0 for functions from the source
+    uint32_t Calls; // head of the functions it references, index + 1 into the compiler's CallEdges
+    bool Reached; // reachable from main
+} Function;
+
+typedef struct VarNode VarNode;
+
+struct VarNode
+{
+    InternId Name;
+    TypeDesc Type;
+    QWord AddressOffset;
+    QWord Register; // nonzero if the local lives in a register instead of at AddressOffset
+    Function *Func;
+    VarNode *Next; // previous declaration in the same scope
+    VarNode *Shadowed; // what Name meant before this declaration
+};
+
+typedef struct
+{
+    ArenaMark Mark;
+    VarNode *Vars; // newest first
+} Scope;
+
+// intern ids are small and dense so they index the table directly, no hashing needed on top
+typedef struct
+{
+    VarNode **ByName; // innermost declaration of each id
+    size_t Capacity;
+
+    Scope *Scopes; // Scopes[0] is the global scope, pushed on first use
+    size_t ScopeCount;
+    size_t ScopeCapacity;
+
+    Arena Mem; // every VarNode and Function, rolled back when their scope is popped
+} SymTable;
+
+void SymTable_PushScope(SymTable *Table);
+
+// drops every declaration made since the matching push and frees their memory
+void SymTable_PopScope(SymTable *Table);
+
+// declares Name in the innermost scope, the node comes back zeroed
+VarNode *SymTable_Define(SymTable *Table, InternId Name);
+
+// zeroed, lives as long as the scope it was made in
+Function *SymTable_NewFunc(SymTable *Table);
+
+static inline VarNode *SymTable_Lookup(SymTable *Table, InternId Name)
+{
+    return (Name < Table->Capacity) ? Table->ByName[Name] : NULL;
+}
+
+void SymTable_Free(SymTable *Table);
+
+#endif // SYMTABLE_H